@@ -82,19 +82,239 @@ void test_fixed_size_allocations_and_frees(size_t fixed_size, size_t num_operati
 		<< (diff.count() / (num_operations / 1e6)) << "ms/Mops" << std::endl;
 
 	// slabAlloc.print_stats(); // Enable if needed
+#if SLAB_ENABLE_CYCLES
+	slabAlloc.cycle_stats().write_json(std::cout);
+	std::cout << std::endl;
+#endif
 
 	// Cleanup
 	// SlabAllocator destructor will automatically release resources
 }
 
+// allocate/deallocate alone: the operation stream is drawn before the clock starts, so builds with
+// different SLAB_ENABLE_* modes time exactly the same calls and can be compared line by line
+void test_allocator_cost(size_t fixed_size, size_t num_operations) {
+	std::vector<uint32_t> ops(num_operations); // UINT32_MAX = allocate, otherwise free the live pointer at that index
+	Xorshift64 rng(42);
+	size_t live = 0;
+	for (uint32_t& op : ops) {
+		if ((rng.next_u64() % 2 == 0 || live == 0) && live < MAX_ALLOCATIONS) {
+			op = UINT32_MAX;
+			++live;
+		}
+		else {
+			op = static_cast<uint32_t>(rng.next_u64() % live);
+			--live;
+		}
+	}
+
+	std::vector<void*> ptrs;
+	ptrs.reserve(MAX_ALLOCATIONS);
+	slab::SlabAllocator slabAlloc(fixed_size, 1);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const uint32_t op : ops) {
+		if (op == UINT32_MAX) {
+			ptrs.push_back(slabAlloc.allocate());
+		}
+		else {
+			slabAlloc.deallocate(ptrs[op]);
+			ptrs[op] = ptrs.back();
+			ptrs.pop_back();
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::nano> diff = end - start;
+	std::cout << "[Size " << fixed_size << "] allocator cost: " << (diff.count() / num_operations) << "ns/op" << std::endl;
+}
+
+static size_t malloc_calls = 0;
+
+static void* counting_malloc(size_t size) {
+	++malloc_calls;
+	return std::malloc(size);
+}
+
+// a live set that keeps crossing a slab boundary, the worst case for a small reserved_limit
+void test_slab_churn(size_t fixed_size, size_t num_cycles) {
+	std::vector<void*> ptrs;
+	ptrs.reserve(128);
+	slab::_malloc = counting_malloc;
+
+	for (bool adaptive : { false, true }) {
+		slab::SlabAllocator slabAlloc(fixed_size, 1);
+		slabAlloc.set_adaptive_reserve(adaptive);
+		malloc_calls = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < num_cycles; ++i) {
+			for (size_t j = 0; j < 65; ++j) {
+				ptrs.push_back(slabAlloc.allocate());
+			}
+			while (!ptrs.empty()) {
+				slabAlloc.deallocate(ptrs.back());
+				ptrs.pop_back();
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double, std::milli> diff = end - start;
+		std::cout << "[Size " << fixed_size << "] Churn " << (adaptive ? "adaptive: " : "fixed:    ") << diff.count() << "ms, "
+			<< malloc_calls << " malloc calls, reserve " << slabAlloc.reserve_limit() << std::endl;
+	}
+
+	slab::_malloc = std::malloc;
+}
+
+#if SLAB_ENABLE_PTR_TAG || SLAB_ENABLE_GENERATIONS || SLAB_ENABLE_QUARANTINE
+// behaviour checks of the safety modes, they abort on failure even in NDEBUG builds
+static void expect(const bool ok, const char* what) {
+	if (!ok) {
+		std::cerr << "safety check failed: " << what << std::endl;
+		std::abort();
+	}
+}
+#endif
+
+#if SLAB_ENABLE_PTR_TAG || SLAB_ENABLE_GENERATIONS
+struct Tracked {
+	static int destroyed;
+	int value;
+
+	explicit Tracked(const int value) : value(value) {}
+	~Tracked() { ++destroyed; }
+};
+int Tracked::destroyed = 0;
+
+// the reuse checks need a freed unit to come back at once, which the quarantine delays on purpose
+template<typename Pool>
+static void reuse_at_once(Pool& pool) {
+#if SLAB_ENABLE_QUARANTINE
+	pool.set_quarantine(0);
+#else
+	(void)pool;
+#endif
+}
+
+// fill the rest of the first slab, so the unit freed next is the only one allocate can pick (random selection too)
+static std::vector<Tracked*> fill_slab(slab::ObjectPool<Tracked>& pool) {
+	std::vector<Tracked*> fillers;
+	for (int i = 0; i < 63; ++i) fillers.push_back(pool.allocate(0));
+	return fillers;
+}
+#endif
+
+void test_safety_modes() {
+#if SLAB_ENABLE_PTR_TAG
+	{
+		slab::ObjectPool<Tracked> pool;
+		reuse_at_once(pool);
+		Tracked* first = pool.allocate(1);
+		const std::vector<Tracked*> fillers = fill_slab(pool);
+		pool.deallocate(first);
+		Tracked* second = pool.allocate(2); // same unit, next tag
+		expect(slab::untag(first) == slab::untag(second) && first != second, "a reused unit gets a new tag");
+
+		Tracked::destroyed = 0;
+		pool.deallocate(first);
+		expect(Tracked::destroyed == 0 && slab::untag(second)->value == 2, "a stale free leaves the new object alone");
+		pool.deallocate(second);
+		expect(Tracked::destroyed == 1, "the live free still goes through");
+		for (Tracked* filler : fillers) pool.deallocate(filler);
+	}
+	{
+		// destroyed and recreated slabs must not hand out the old names again
+		slab::SlabAllocator allocator(16, 0);
+		reuse_at_once(allocator);
+		std::vector<void*> old_ptrs, new_ptrs;
+		for (int i = 0; i < 128; ++i) old_ptrs.push_back(allocator.allocate());
+		for (void* ptr : old_ptrs) allocator.deallocate(ptr);
+		for (int i = 0; i < 128; ++i) new_ptrs.push_back(allocator.allocate());
+		for (int i = 0; i < 128; ++i) expect(old_ptrs[i] != new_ptrs[i], "a recreated slab starts past the old tags");
+
+		allocator.deallocate(old_ptrs[0]);
+		expect(allocator.snapshot().live_units == 128, "a stale free into a recreated slab is rejected");
+
+		slab::SlabAllocator other(16);
+		void* foreign = other.allocate();
+		allocator.deallocate(foreign);
+		allocator.deallocate(static_cast<char*>(new_ptrs[1]) + 8);
+		allocator.deallocate(static_cast<char*>(new_ptrs[1]) + 3);
+		expect(allocator.snapshot().live_units == 128 && other.snapshot().live_units == 1, "foreign and interior frees are rejected");
+
+		other.deallocate(foreign);
+		for (void* ptr : new_ptrs) allocator.deallocate(ptr);
+		expect(allocator.snapshot().live_units == 0, "every live pointer frees once");
+	}
+	std::cout << "pointer tag checks passed" << std::endl;
+#endif
+
+#if SLAB_ENABLE_GENERATIONS
+	{
+		slab::ObjectPool<Tracked> pool;
+		reuse_at_once(pool);
+		const slab::Handle first = pool.allocate_checked(1);
+		const std::vector<Tracked*> fillers = fill_slab(pool);
+		pool.deallocate(first);
+		expect(pool.get(first) == nullptr, "a freed handle is stale");
+
+		const slab::Handle second = pool.allocate_checked(2); // same unit, next generation
+		expect(first.index == second.index && first != second, "a reused unit gets a new generation");
+
+		Tracked::destroyed = 0;
+		pool.deallocate(first);
+		expect(Tracked::destroyed == 0 && pool.get(second) != nullptr && pool.get(second)->value == 2, "a stale handle frees nothing");
+		pool.deallocate(second);
+		expect(Tracked::destroyed == 1 && pool.get(second) == nullptr, "the live handle still frees");
+		for (Tracked* filler : fillers) pool.deallocate(filler);
+	}
+	std::cout << "generation checks passed" << std::endl;
+#endif
+
+#if SLAB_ENABLE_QUARANTINE
+	{
+		slab::SlabAllocator allocator(64);
+		allocator.set_quarantine(1 << 16);
+		void* ptr = allocator.allocate();
+		allocator.deallocate(ptr);
+		expect(allocator.quarantined() == 1, "a free is parked");
+
+		allocator.deallocate(ptr);
+		expect(allocator.quarantined() == 1, "a double free of a parked unit is rejected");
+
+		void* next = allocator.allocate();
+		expect(slab::untag(next) != slab::untag(ptr), "a parked unit is not handed out again");
+		allocator.deallocate(next);
+	}
+	std::cout << "quarantine checks passed" << std::endl;
+#endif
+}
+
 int main() {
+	test_safety_modes();
+
 	size_t sizes[] = { 8, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64, 80, 96, 112, 128, 192, 256, 384, 512, 768, 1024, 2048, 4096 };
 	size_t num_operations = 4e6; // Increase number of operations
 
+	// the modes change the allocator's layout, build once per mode and compare the "allocator cost" lines
+	std::cout << "guard (canary + poison): " << (SLAB_ENABLE_GUARD ? "on" : "off") << std::endl;
+	std::cout << "unit selection: " << (SLAB_ENABLE_RANDOM_UNIT ? "random" : "lowest") << std::endl << std::endl;
+
 	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
 		test_fixed_size_allocations_and_frees(sizes[i], num_operations);
 		std::cout << std::endl;
 	}
 
+	size_t cost_sizes[] = { 16, 64, 256, 1024, 4096 };
+	for (size_t i = 0; i < sizeof(cost_sizes) / sizeof(cost_sizes[0]); ++i) {
+		test_allocator_cost(cost_sizes[i], num_operations);
+	}
+	std::cout << std::endl;
+
+
+	size_t churn_sizes[] = { 16, 256, 4096 };
+	for (size_t i = 0; i < sizeof(churn_sizes) / sizeof(churn_sizes[0]); ++i) {
+		test_slab_churn(churn_sizes[i], num_operations / 130);
+	}
+
 	return 0;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
  * See LICENSE file in the root directory for full license text.
 */
 #pragma once  
+#include <cstddef>
 #include <cstdint>  
 #include <type_traits> // Ensure this header is included for std::enable_if and std::is_integral
 
@@ -11,6 +12,22 @@
 #include <intrin.h> // Ensure this header is included for MSVC intrinsic functions  
 #endif
 
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define BITS_HAS_PDEP 1
+#endif
+
+// x86 vector kernels for bitmap arrays, picked at runtime by CPUID
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+#include <immintrin.h>
+#define BITS_HAS_X86_KERNELS 1
+#define BITS_TARGET(isa)
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define BITS_HAS_X86_KERNELS 1
+#define BITS_TARGET(isa) __attribute__((target(isa)))
+#endif
+
 namespace bits {
 	template <typename T, typename = std::enable_if<std::is_integral_v<T>>>
 	T ceil(T x) {
@@ -109,4 +126,234 @@ namespace bits {
 		return n;
 #endif
 	}
-}
\ No newline at end of file
+
+	/**
+	 * @brief position of the r-th set bit of x (r counts from 0, r < popcnt64(x))
+	 * @note pdep is a single uop on Intel and AMD Zen 3+, but microcoded and slow on Zen 1/2
+	 */
+	static inline uint8_t select64(uint64_t x, uint32_t r) {
+#if defined(BITS_HAS_PDEP)
+		return ctz64(_pdep_u64(static_cast<uint64_t>(1) << r, x));
+#else
+		// SWAR byte counts, their running sum picks the byte, then clear r lower bits inside it
+		uint64_t counts = x - ((x >> 1) & 0x5555555555555555ULL);
+		counts = (counts & 0x3333333333333333ULL) + ((counts >> 2) & 0x3333333333333333ULL);
+		counts = (counts + (counts >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		const uint64_t prefix = counts * 0x0101010101010101ULL; // byte i = set bits in bytes 0..i
+
+		uint32_t shift = 0;
+		while (((prefix >> shift) & 0xFF) <= r) {
+			shift += 8;
+		}
+
+		if (shift != 0) {
+			r -= static_cast<uint32_t>((prefix >> (shift - 8)) & 0xFF);
+		}
+
+		uint64_t byte = (x >> shift) & 0xFF;
+		while (r-- != 0) {
+			byte &= byte - 1;
+		}
+		return static_cast<uint8_t>(shift + ctz64(byte));
+#endif
+	}
+
+	// ---- kernels over arrays of 64-bit bitmap words, bit i of the array is bit (i & 63) of words[i >> 6] ----
+
+	enum class Isa : uint8_t {
+		scalar,
+		avx2,		// 256-bit nibble-lookup popcount
+		avx512,		// avx512f + vpopcntq
+	};
+
+	namespace detail {
+		static inline uint64_t popcnt_array_scalar(const uint64_t* words, const size_t n) {
+			uint64_t total = 0;
+			for (size_t i = 0; i < n; ++i) {
+				total += popcnt64(words[i]);
+			}
+			return total;
+		}
+
+		static inline size_t find_first_set_scalar(const uint64_t* words, const size_t n) {
+			for (size_t i = 0; i < n; ++i) {
+				if (words[i] != 0) return i * 64 + ctz64(words[i]);
+			}
+			return n * 64;
+		}
+
+#if defined(BITS_HAS_X86_KERNELS)
+		BITS_TARGET("avx2,popcnt")
+		static inline uint64_t popcnt_array_avx2(const uint64_t* words, const size_t n) {
+			// per-nibble counts via vpshufb, summed per 64-bit lane by vpsadbw
+			const __m256i lookup = _mm256_setr_epi8(
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			const __m256i low = _mm256_set1_epi8(0x0F);
+			__m256i acc = _mm256_setzero_si256();
+
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+				const __m256i counts = _mm256_add_epi8(
+					_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+					_mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+				acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+			}
+
+			uint64_t total = static_cast<uint64_t>(_mm256_extract_epi64(acc, 0)) + static_cast<uint64_t>(_mm256_extract_epi64(acc, 1))
+				+ static_cast<uint64_t>(_mm256_extract_epi64(acc, 2)) + static_cast<uint64_t>(_mm256_extract_epi64(acc, 3));
+			for (; i < n; ++i) {
+				total += popcnt64(words[i]);
+			}
+			return total;
+		}
+
+		BITS_TARGET("avx2")
+		static inline size_t find_first_set_avx2(const uint64_t* words, const size_t n) {
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+				if (!_mm256_testz_si256(v, v)) break;
+			}
+			return i * 64 + find_first_set_scalar(words + i, n - i);
+		}
+
+		BITS_TARGET("avx512f,avx512vpopcntdq")
+		static inline uint64_t popcnt_array_avx512(const uint64_t* words, const size_t n) {
+			__m512i acc = _mm512_setzero_si512();
+
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+			}
+			if (i < n) {
+				const __mmask8 tail = static_cast<__mmask8>((1u << (n - i)) - 1);
+				acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, words + i)));
+			}
+			// _mm512_reduce_add_epi64 trips -Wuninitialized inside GCC 12's own headers
+			alignas(64) uint64_t lanes[8];
+			_mm512_store_si512(lanes, acc);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+		}
+
+		BITS_TARGET("avx512f")
+		static inline size_t find_first_set_avx512(const uint64_t* words, const size_t n) {
+			for (size_t i = 0; i < n; i += 8) {
+				const __mmask8 valid = n - i >= 8 ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << (n - i)) - 1);
+				const __m512i v = _mm512_maskz_loadu_epi64(valid, words + i);
+				const uint32_t nonzero = _mm512_test_epi64_mask(v, v);
+				if (nonzero != 0) {
+					const size_t word = i + ctz64(nonzero);
+					return word * 64 + ctz64(words[word]);
+				}
+			}
+			return n * 64;
+		}
+
+		static inline Isa detect_isa() {
+#if defined(_MSC_VER)
+			int regs[4];
+			__cpuid(regs, 0);
+			if (regs[0] < 7) return Isa::scalar;
+
+			__cpuid(regs, 1);
+			const bool osxsave = (regs[2] & (1 << 27)) != 0;
+			const bool popcnt = (regs[2] & (1 << 23)) != 0;
+			if (!osxsave || !popcnt) return Isa::scalar;
+
+			const uint64_t xcr0 = _xgetbv(0);
+			__cpuidex(regs, 7, 0);
+			const bool avx512 = (regs[1] & (1 << 16)) != 0 && (regs[2] & (1 << 14)) != 0 && (xcr0 & 0xE6) == 0xE6;
+			const bool avx2 = (regs[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+#else
+			__builtin_cpu_init();
+			const bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+			const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+			return avx512 ? Isa::avx512 : avx2 ? Isa::avx2 : Isa::scalar;
+		}
+#else
+		static inline Isa detect_isa() {
+			return Isa::scalar;
+		}
+#endif
+	}
+
+	/**
+	 * @brief widest kernel set the running CPU supports, detected once
+	 */
+	static inline Isa isa() {
+		static const Isa value = detail::detect_isa();
+		return value;
+	}
+
+	/**
+	 * @brief set bits in words[0..n)
+	 */
+	static inline uint64_t popcnt_array(const uint64_t* words, const size_t n, const Isa use = isa()) {
+#if defined(BITS_HAS_X86_KERNELS)
+		if (use == Isa::avx512) return detail::popcnt_array_avx512(words, n);
+		if (use == Isa::avx2) return detail::popcnt_array_avx2(words, n);
+#else
+		(void)use;
+#endif
+		return detail::popcnt_array_scalar(words, n);
+	}
+
+	/**
+	 * @brief index of the lowest set bit in words[0..n), n * 64 if there is none (like ctz64)
+	 */
+	static inline size_t find_first_set(const uint64_t* words, const size_t n, const Isa use = isa()) {
+#if defined(BITS_HAS_X86_KERNELS)
+		if (use == Isa::avx512) return detail::find_first_set_avx512(words, n);
+		if (use == Isa::avx2) return detail::find_first_set_avx2(words, n);
+#else
+		(void)use;
+#endif
+		return detail::find_first_set_scalar(words, n);
+	}
+
+	/**
+	 * @brief start of the lowest run of k consecutive set bits (k >= 1), n * 64 if there is none
+	 * @note runs may cross word boundaries; stretches of zero words are skipped with find_first_set
+	 */
+	static inline size_t find_run(const uint64_t* words, const size_t n, const uint32_t k, const Isa use = isa()) {
+		if (k == 0) return 0;
+
+		size_t run = 0;	// set bits ending at the top of the previous word
+		for (size_t i = 0; i < n; ++i) {
+			if (run == 0 && words[i] == 0) {
+				// nothing carried in, jump to the next word with a set bit
+				const size_t next = find_first_set(words + i, n - i, use);
+				if (next == (n - i) * 64) break;
+				i += next / 64;
+			}
+
+			const uint64_t w = words[i];
+			if (w == ~static_cast<uint64_t>(0)) {
+				run += 64;
+				if (run >= k) return (i + 1) * 64 - run;
+				continue;
+			}
+
+			// the carried run continues into the low bits of w
+			const size_t head = ctz64(~w);
+			if (run + head >= k) return i * 64 - run;
+
+			if (k <= 64) {
+				// bit j of x survives when bits j..j+k-1 of w are all set
+				uint64_t x = w;
+				for (uint32_t len = 1; len < k;) {
+					const uint32_t step = len < k - len ? len : k - len;
+					x &= x >> step;
+					len += step;
+				}
+				if (x != 0) return i * 64 + ctz64(x);
+			}
+
+			run = clz64(~w);
+		}
+		return n * 64;
+	}
+}
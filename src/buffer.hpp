@@ -0,0 +1,278 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "./mapping.hpp"
+#include "./slab.hpp"
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#endif
+
+namespace slab {
+	/**
+	 * @brief pool of page-aligned I/O buffers whose memory never moves
+	 *
+	 * Slabs of 64 buffers are carved from one mapping made at construction, so the set of regions can be
+	 * registered once (io_uring fixed buffers, RDMA, ...) and stays valid for the pool's lifetime.
+	 * Slab metadata lives out of line; nothing is written in front of a buffer, which keeps every
+	 * buffer on a page boundary and a page multiple long. The metadata is a two-level bitmap: a free word
+	 * per slab in address order and a summary bit per slab with room, searched with the bits:: array kernels.
+	 */
+	class BufferPool {
+	public:
+		struct Region {
+			void* base;
+			size_t length;
+		};
+
+		// where a buffer sits in the registered regions: region is the buf_index for IORING_OP_READ_FIXED
+		// (whose addr stays the buffer pointer itself), offset the byte position inside that region
+		struct Location {
+			uint32_t region;	// UINT32_MAX if the pointer is not in this pool
+			uint64_t offset;
+		};
+
+		static constexpr uint64_t region_limit = 1ull << 30;	// io_uring takes fixed buffers of at most 1 GiB
+
+	protected:
+		Mapping mapping;
+		char* base = nullptr;
+		uint32_t buffer_size = 0;
+		uint64_t slab_bytes = 0;
+		uint64_t region_bytes = 0;	// whole buffers, at most region_limit unless one buffer is larger
+		// bit i is buffer i, 1 = free; one word per slab, in address order
+		std::vector<uint64_t> free_maps;
+		// bit s is set while slab s has a free buffer, the upper level allocate searches
+		std::vector<uint64_t> summary;
+		size_t summary_hint = 0;	// no summary word below this one has a set bit
+
+		void markUsed(const size_t slabIndex, const uint64_t bits) {
+			uint64_t& map = this->free_maps[slabIndex];
+			map &= ~bits;
+			if (map == 0) bits::set_zero(this->summary[slabIndex >> 6], static_cast<uint8_t>(slabIndex & 63));
+		}
+
+		void markFree(const size_t slabIndex, const uint64_t bits) {
+			this->free_maps[slabIndex] |= bits;
+			bits::set_one(this->summary[slabIndex >> 6], static_cast<uint8_t>(slabIndex & 63));
+			this->summary_hint = std::min(this->summary_hint, slabIndex >> 6);
+		}
+
+		// buffers [first, first + count) as per-slab masks
+		template<typename Fn>
+		static void forEachSlab(const size_t first, const size_t count, Fn&& fn) {
+			for (size_t at = first, end = first + count; at < end;) {
+				const uint32_t bit = static_cast<uint32_t>(at & 63);
+				const uint32_t take = static_cast<uint32_t>(std::min<size_t>(64 - bit, end - at));
+				fn(at >> 6, (take == 64 ? UINT64_MAX : ((static_cast<uint64_t>(1) << take) - 1)) << bit);
+				at += take;
+			}
+		}
+
+		// index of ptr if it is the start of a buffer of this pool, SIZE_MAX otherwise
+		size_t checkedIndex(const void* ptr) const {
+			const char* p = static_cast<const char*>(ptr);
+			if (p == nullptr || p < this->base || p >= this->base + this->mapping.size()) return SIZE_MAX;
+
+			const uint64_t offset = static_cast<uint64_t>(p - this->base);
+			return offset % this->buffer_size == 0 ? static_cast<size_t>(offset / this->buffer_size) : SIZE_MAX;
+		}
+
+	public:
+		BufferPool(const BufferPool&) = delete;
+		BufferPool& operator=(const BufferPool&) = delete;
+
+		BufferPool(BufferPool&&) = delete;
+		BufferPool& operator=(BufferPool&&) = delete;
+
+		/**
+		 * @param bufferSize rounded up to a multiple of the page size
+		 * @param slabCount slabs of 64 buffers; address space is reserved up front, pages commit on first touch
+		 */
+		BufferPool(uint32_t bufferSize, const uint32_t slabCount) {
+			const size_t page = Mapping::page_size();
+			if (bufferSize == 0 || slabCount == 0 || slabCount > (1u << 26)) {
+				std::cerr << "Invalid bufferSize or slabCount for BufferPool" << std::endl;
+				exit(1);
+			}
+
+			bufferSize = static_cast<uint32_t>((bufferSize + page - 1) / page * page);
+			this->buffer_size = bufferSize;
+			this->slab_bytes = static_cast<uint64_t>(64) * bufferSize;
+			this->region_bytes = std::max<uint64_t>(region_limit / bufferSize, 1) * bufferSize;
+
+			this->mapping = Mapping::anonymous(static_cast<size_t>(this->slab_bytes * slabCount));
+			if (!this->mapping) {
+				std::cerr << "BufferPool: failed in allocating memory." << std::endl;
+				exit(1);
+			}
+			this->base = static_cast<char*>(this->mapping.data());
+
+			this->free_maps.assign(slabCount, UINT64_MAX);
+			this->summary.assign((slabCount + 63) / 64, UINT64_MAX);
+			if (slabCount % 64 != 0) {
+				this->summary.back() = (static_cast<uint64_t>(1) << (slabCount % 64)) - 1;
+			}
+		}
+
+		/**
+		 * @return a page-aligned buffer of bufferSize() bytes, the lowest free one; nullptr when every buffer is in use
+		 */
+		void* allocate() {
+			const size_t words = this->summary.size() - this->summary_hint;
+			const size_t found = bits::find_first_set(this->summary.data() + this->summary_hint, words);
+			if (found == words * 64) {
+				this->summary_hint = this->summary.size();
+				std::cerr << "BufferPool: all " << this->capacity() << " buffers are in use." << std::endl;
+				return nullptr;
+			}
+
+			const size_t slabIndex = this->summary_hint * 64 + found;
+			this->summary_hint = slabIndex >> 6;
+
+			const uint32_t index = bits::ctz64(this->free_maps[slabIndex]);
+			this->markUsed(slabIndex, static_cast<uint64_t>(1) << index);
+			return this->buffer(static_cast<UnitHandle>((slabIndex << 6) | index));
+		}
+
+		/**
+		 * @brief count buffers that are adjacent in memory, so one readv/writev or DMA can span them
+		 * @return the first of them, nullptr if no free run that long exists
+		 * @note a run may cross slabs and registered regions, locate() tells where each part lives
+		 */
+		void* allocate_run(const uint32_t count) {
+			const size_t found = count == 0 ? this->free_maps.size() * 64 : bits::find_run(this->free_maps.data(), this->free_maps.size(), count);
+			if (found == this->free_maps.size() * 64) {
+				std::cerr << "BufferPool: no run of " << count << " free buffers." << std::endl;
+				return nullptr;
+			}
+
+			forEachSlab(found, count, [this](const size_t slabIndex, const uint64_t mask) {
+				this->markUsed(slabIndex, mask);
+			});
+			return this->buffer(static_cast<UnitHandle>(found));
+		}
+
+		void deallocate(void* ptr) {
+			const size_t index = this->checkedIndex(ptr);
+			if (index == SIZE_MAX) {
+				std::cerr << "deallocate: Invalid pointer for BufferPool." << std::endl;
+				return;
+			}
+
+			if (bits::get(this->free_maps[index >> 6], static_cast<uint8_t>(index & 63)) != 0) {
+				std::cerr << "deallocate: Unit is already freed in bitMap." << std::endl;
+				return;
+			}
+
+			this->markFree(index >> 6, static_cast<uint64_t>(1) << (index & 63));
+		}
+
+		/**
+		 * @brief free count buffers taken by allocate_run, ptr is what it returned
+		 */
+		void deallocate_run(void* ptr, const uint32_t count) {
+			const size_t index = this->checkedIndex(ptr);
+			if (index == SIZE_MAX || count == 0 || count > this->capacity() - index) {
+				std::cerr << "deallocate_run: Invalid pointer or count for BufferPool." << std::endl;
+				return;
+			}
+
+			bool allUsed = true;
+			forEachSlab(index, count, [this, &allUsed](const size_t slabIndex, const uint64_t mask) {
+				allUsed &= (this->free_maps[slabIndex] & mask) == 0;
+			});
+			if (!allUsed) {
+				std::cerr << "deallocate_run: Unit is already freed in bitMap." << std::endl;
+				return;
+			}
+
+			forEachSlab(index, count, [this](const size_t slabIndex, const uint64_t mask) {
+				this->markFree(slabIndex, mask);
+			});
+		}
+
+		/**
+		 * @brief buffer index, (slab << 6) | unit, the same numbering as UnitHandle; invalid_handle outside the pool
+		 */
+		UnitHandle index_of(const void* ptr) const {
+			const char* p = static_cast<const char*>(ptr);
+			if (p == nullptr || p < this->base || p >= this->base + this->mapping.size()) return invalid_handle;
+			return static_cast<UnitHandle>(static_cast<uint64_t>(p - this->base) / this->buffer_size);
+		}
+
+		void* buffer(const UnitHandle index) const {
+			return this->base + static_cast<uint64_t>(index) * this->buffer_size;
+		}
+
+		/**
+		 * @brief registered region and offset inside it of any byte of a buffer
+		 */
+		Location locate(const void* ptr) const {
+			const char* p = static_cast<const char*>(ptr);
+			if (p == nullptr || p < this->base || p >= this->base + this->mapping.size()) return { UINT32_MAX, 0 };
+
+			const uint64_t offset = static_cast<uint64_t>(p - this->base);
+			return { static_cast<uint32_t>(offset / this->region_bytes), offset % this->region_bytes };
+		}
+
+		/**
+		 * @brief the pool in as few regions as io_uring accepts: consecutive, at most 1 GiB each, never splitting a buffer
+		 */
+		std::vector<Region> regions() const {
+			const uint64_t total = this->mapping.size();
+			std::vector<Region> out;
+			out.reserve(static_cast<size_t>((total + this->region_bytes - 1) / this->region_bytes));
+			for (uint64_t at = 0; at < total; at += this->region_bytes) {
+				out.push_back({ this->base + at, static_cast<size_t>(std::min(this->region_bytes, total - at)) });
+			}
+			return out;
+		}
+
+#if !defined(_WIN32)
+		/**
+		 * @brief regions() as iovecs, ready for io_uring_register_buffers
+		 */
+		std::vector<iovec> region_iovecs() const {
+			const std::vector<Region> regions = this->regions();
+			std::vector<iovec> out;
+			out.reserve(regions.size());
+			for (const Region& region : regions) {
+				out.push_back({ region.base, region.length });
+			}
+			return out;
+		}
+
+		/**
+		 * @brief iovec over the first length bytes of a buffer for readv/writev
+		 */
+		iovec iov(void* buffer, const size_t length) const {
+			return { buffer, length < this->buffer_size ? length : this->buffer_size };
+		}
+#endif
+
+		uint32_t bufferSize() const {
+			return this->buffer_size;
+		}
+
+		/**
+		 * @brief buffers in use, counted over the free maps (one vpopcntq per 8 slabs where AVX-512 is available)
+		 */
+		uint64_t live() const {
+			return this->capacity() - bits::popcnt_array(this->free_maps.data(), this->free_maps.size());
+		}
+
+		uint64_t capacity() const {
+			return static_cast<uint64_t>(this->free_maps.size()) * 64;
+		}
+	};
+}
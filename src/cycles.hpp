@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace slab::cycles {
+	enum Path : uint32_t {
+		alloc_fast,		// unit taken from the work head
+		alloc_create,	// work list was empty, makeBlock
+		alloc_to_full,	// slab became full, work -> full move
+		free_fast,		// bit set back, no list change
+		free_to_work,	// slab was full, full -> work move
+		free_destroy,	// slab became empty beyond the reserve, destroyed
+		free_error,		// invalid or double free
+		path_count
+	};
+
+	static constexpr const char* path_names[path_count] = {
+		"alloc_fast", "alloc_create", "alloc_to_full",
+		"free_fast", "free_to_work", "free_destroy", "free_error"
+	};
+
+	/**
+	 * @brief timestamp counter, rdtscp where available (waits for earlier instructions to retire)
+	 * @note the fallback counts nanoseconds instead of cycles
+	 */
+	static inline uint64_t now() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		unsigned int aux;
+		return __rdtscp(&aux);
+#else
+		return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	/**
+	 * @brief cost of a back-to-back now() pair, subtracted from every measurement
+	 */
+	static inline uint64_t overhead() {
+		static const uint64_t value = [] {
+			uint64_t best = UINT64_MAX;
+			for (uint32_t i = 0; i < 1024; ++i) {
+				const uint64_t start = now();
+				const uint64_t delta = now() - start;
+				if (delta < best) best = delta;
+			}
+			return best;
+		}();
+		return value;
+	}
+
+	struct Bucket {
+		uint64_t count = 0;
+		uint64_t cycles = 0;
+	};
+
+	struct CycleStats {
+		Bucket buckets[path_count];
+
+		void write_json(std::ostream& os) const {
+			os << "{";
+			for (uint32_t i = 0; i < path_count; ++i) {
+				const Bucket& b = this->buckets[i];
+				os << (i ? "," : "") << "\"" << path_names[i] << "\":{\"count\":" << b.count
+					<< ",\"cycles\":" << b.cycles
+					<< ",\"avg\":" << (b.count ? static_cast<double>(b.cycles) / static_cast<double>(b.count) : 0.0) << "}";
+			}
+			os << "}";
+		}
+	};
+
+	/**
+	 * @brief times one allocate/deallocate call and charges it to the path it ended up taking
+	 */
+	class Scope {
+	protected:
+		CycleStats& stats;
+		uint64_t start;
+		Path path;
+
+	public:
+		Scope(CycleStats& stats, const Path path) : stats(stats), start(now()), path(path) {}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		void set(const Path path) {
+			this->path = path;
+		}
+
+		~Scope() {
+			const uint64_t delta = now() - this->start;
+			const uint64_t bias = overhead();
+
+			Bucket& bucket = this->stats.buckets[this->path];
+			bucket.cycles += delta > bias ? delta - bias : 0;
+			++bucket.count;
+		}
+	};
+}
@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+namespace slab {
+	/**
+	 * @brief time series of per-slab occupancy, rendered offline by tools/heatmap.cpp
+	 *
+	 * file layout (little endian):
+	 *   "SLABHM01"
+	 *   record*: u64 microseconds since open, u32 allocator id, u32 unit size, u32 slab count,
+	 *            then per slab sorted by address: varint((address - previous) >> 3), u8 live units
+	 */
+	class HeatmapRecorder {
+	protected:
+		std::ofstream file;
+		std::chrono::steady_clock::time_point origin;
+		std::chrono::steady_clock::time_point last;
+		std::chrono::milliseconds interval;
+		std::vector<std::pair<uintptr_t, uint8_t>> slabs;	// reused between samples
+
+		void put(const void* data, const size_t size) {
+			this->file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		}
+
+		void putU32(uint32_t value) {
+			uint8_t bytes[4];
+			for (uint32_t i = 0; i < 4; ++i, value >>= 8) bytes[i] = static_cast<uint8_t>(value);
+			this->put(bytes, 4);
+		}
+
+		void putU64(uint64_t value) {
+			uint8_t bytes[8];
+			for (uint32_t i = 0; i < 8; ++i, value >>= 8) bytes[i] = static_cast<uint8_t>(value);
+			this->put(bytes, 8);
+		}
+
+		void putVarint(uint64_t value) {
+			uint8_t bytes[10];
+			uint32_t n = 0;
+			while (value >= 0x80) {
+				bytes[n++] = static_cast<uint8_t>(value | 0x80);
+				value >>= 7;
+			}
+			bytes[n++] = static_cast<uint8_t>(value);
+			this->put(bytes, n);
+		}
+
+	public:
+		HeatmapRecorder(const HeatmapRecorder&) = delete;
+		HeatmapRecorder& operator=(const HeatmapRecorder&) = delete;
+
+		/**
+		 * @param interval period reported by due()
+		 */
+		HeatmapRecorder(const char* path, const std::chrono::milliseconds interval = std::chrono::milliseconds(1000))
+			: file(path, std::ios::binary | std::ios::trunc), origin(std::chrono::steady_clock::now()), last(origin), interval(interval) {
+			if (!this->file) {
+				std::cerr << "HeatmapRecorder: cannot open " << path << std::endl;
+				return;
+			}
+
+			this->put("SLABHM01", 8);
+		}
+
+		bool is_open() const {
+			return this->file.is_open() && this->file.good();
+		}
+
+		/**
+		 * @brief append one record for the allocator, must run on the allocator's owning thread
+		 * @param id tag that tells the allocators in one file apart
+		 */
+		template<typename Allocator>
+		void sample(const Allocator& allocator, const uint32_t id) {
+			if (!this->is_open()) return;
+
+			this->slabs.clear();
+			allocator.visit_slabs([this](const void* slab, const uint32_t live) {
+				this->slabs.emplace_back(reinterpret_cast<uintptr_t>(slab), static_cast<uint8_t>(live));
+			});
+			std::sort(this->slabs.begin(), this->slabs.end());
+
+			const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->origin);
+			this->putU64(static_cast<uint64_t>(elapsed.count()));
+			this->putU32(id);
+			this->putU32(allocator.unitSize());
+			this->putU32(static_cast<uint32_t>(this->slabs.size()));
+
+			uintptr_t previous = 0;
+			for (const auto& slab : this->slabs) {
+				this->putVarint((slab.first - previous) >> 3);
+				this->file.put(static_cast<char>(slab.second));
+				previous = slab.first;
+			}
+		}
+
+		/**
+		 * @brief true once per interval, then sample every allocator of interest
+		 */
+		bool due() {
+			const auto now = std::chrono::steady_clock::now();
+			if (now - this->last < this->interval) return false;
+
+			this->last = now;
+			return true;
+		}
+
+		void flush() {
+			this->file.flush();
+		}
+	};
+}
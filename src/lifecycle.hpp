@@ -0,0 +1,184 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+namespace slab {
+	// where every slab and every piece of bookkeeping memory comes from
+	static void* (*_malloc)(size_t size) = std::malloc;
+	static void (*_free)(void*) = std::free;
+
+	/**
+	 * @brief circular doubly linked slab lists (work/full) shared by the pools
+	 *
+	 * A list is its head pointer, nullptr when empty; any node type with next/prev pointers works.
+	 */
+	namespace list {
+		template<typename Node>
+		static inline void unlink(Node*& head, Node* node) {
+			if (node->next == node) {
+				head = nullptr;
+				return;
+			}
+
+			node->prev->next = node->next;
+			node->next->prev = node->prev;
+			if (head == node) head = node->next;
+		}
+
+		template<typename Node>
+		static inline void push_front(Node*& head, Node* node) {
+			if (head == nullptr) {
+				node->next = node;
+				node->prev = node;
+			}
+			else {
+				node->next = head;
+				node->prev = head->prev;
+				node->next->prev = node;
+				node->prev->next = node;
+			}
+			head = node;
+		}
+	}
+
+	/**
+	 * @brief the same lists for slabs inside a mapping, linked by slab index instead of by pointer
+	 *
+	 * at(index) returns the node (uint32_t next/prev); a list is its head index, none when empty.
+	 */
+	namespace index_list {
+		constexpr uint32_t none = UINT32_MAX;
+
+		template<typename At>
+		static inline void unlink(uint32_t& head, const uint32_t index, At&& at) {
+			auto* node = at(index);
+			if (node->next == index) {
+				head = none;
+				return;
+			}
+
+			at(node->prev)->next = node->next;
+			at(node->next)->prev = node->prev;
+			if (head == index) head = node->next;
+		}
+
+		template<typename At>
+		static inline void push_front(uint32_t& head, const uint32_t index, At&& at) {
+			auto* node = at(index);
+			if (head == none) {
+				node->next = index;
+				node->prev = index;
+			}
+			else {
+				auto* first = at(head);
+				node->next = head;
+				node->prev = first->prev;
+				at(first->prev)->next = index;
+				first->prev = index;
+			}
+			head = index;
+		}
+	}
+
+	/**
+	 * @brief slot -> slab table behind 32-bit handles ((slot << 6) | unit)
+	 *
+	 * Freed slots are chained through the table itself and reused first, so release never allocates;
+	 * the table grows through _malloc, never through global new, and reports failure instead of throwing.
+	 * Tag is what a slot remembers across release for its owner, it must be trivially copyable.
+	 */
+	template<typename T, typename Tag = uint32_t>
+	class SlotTable {
+		static_assert(std::is_trivially_copyable_v<Tag>, "SlotTable moves tags with memcpy");
+
+	public:
+		static constexpr uint32_t none = UINT32_MAX;
+
+	protected:
+		struct Entry {
+			T* value;			// nullptr while the slot is free
+			uint32_t next_free;	// next free slot while this one is free
+			Tag tag;			// kept across release, for the owner (e.g. the generation a reused slot starts from)
+		};
+
+		Entry* entries = nullptr;
+		uint32_t count = 0;
+		uint32_t capacity = 0;
+		uint32_t free_head = none;
+
+		bool grow() {
+			const uint32_t wanted = this->capacity == 0 ? 16 : this->capacity * 2;
+			Entry* grown = static_cast<Entry*>(_malloc(sizeof(Entry) * wanted));
+			if (grown == nullptr) return false;
+
+			if (this->count != 0) std::memcpy(grown, this->entries, sizeof(Entry) * this->count);
+			_free(this->entries);
+			this->entries = grown;
+			this->capacity = wanted;
+			return true;
+		}
+
+	public:
+		SlotTable() = default;
+		SlotTable(const SlotTable&) = delete;
+		SlotTable& operator=(const SlotTable&) = delete;
+
+		~SlotTable() {
+			_free(this->entries);
+		}
+
+		/**
+		 * @brief put value in a free slot, a released one first
+		 * @return the slot, none if limit slots are in use or memory ran out
+		 */
+		uint32_t acquire(T* value, const uint32_t limit) {
+			uint32_t slot = this->free_head;
+
+			if (slot != none) {
+				this->free_head = this->entries[slot].next_free;
+			}
+			else {
+				if (this->count >= limit || (this->count == this->capacity && !this->grow())) return none;
+				slot = this->count++;
+				this->entries[slot].tag = Tag{};
+			}
+
+			this->entries[slot].value = value;
+			return slot;
+		}
+
+		void release(const uint32_t slot) {
+			this->entries[slot].value = nullptr;
+			this->entries[slot].next_free = this->free_head;
+			this->free_head = slot;
+		}
+
+		/**
+		 * @brief unchecked: slot must be below size()
+		 */
+		T* operator[](const uint32_t slot) const {
+			return this->entries[slot].value;
+		}
+
+		// nullptr for a free or out-of-range slot
+		T* find(const uint32_t slot) const {
+			return slot < this->count ? this->entries[slot].value : nullptr;
+		}
+
+		Tag& tag(const uint32_t slot) {
+			return this->entries[slot].tag;
+		}
+
+		uint32_t size() const {
+			return this->count;
+		}
+	};
+}
@@ -0,0 +1,321 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace slab {
+	/**
+	 * @brief owning view of a memory mapping (anonymous or file backed), unmapped on destruction
+	 */
+	class Mapping {
+	public:
+		enum class Mode : uint8_t {
+			copy_on_write,	// writes stay private to this process (MAP_PRIVATE)
+			shared,			// writes reach the file and every other mapping of it (MAP_SHARED)
+		};
+
+	protected:
+		void* base = nullptr;
+		size_t length = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE section = nullptr;
+		bool anonymous = false;
+#else
+		int fd = -1;
+#endif
+
+		void release() {
+#if defined(_WIN32)
+			if (this->base != nullptr) {
+				if (this->anonymous) VirtualFree(this->base, 0, MEM_RELEASE);
+				else UnmapViewOfFile(this->base);
+			}
+			if (this->section != nullptr) CloseHandle(this->section);
+			if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+			this->file = INVALID_HANDLE_VALUE;
+			this->section = nullptr;
+#else
+			if (this->base != nullptr) munmap(this->base, this->length);
+			if (this->fd >= 0) close(this->fd);
+			this->fd = -1;
+#endif
+			this->base = nullptr;
+			this->length = 0;
+		}
+
+#if !defined(_WIN32)
+		// map.fd is open: size it when creating, then map it shared
+		static Mapping fromDescriptor(Mapping&& map, size_t size, const bool create) {
+			if (create && ftruncate(map.fd, static_cast<off_t>(size)) != 0) {
+				std::cerr << "Mapping: cannot size shared memory to " << size << " bytes" << std::endl;
+				return Mapping();
+			}
+
+			struct stat st;
+			if (!create && size == 0) {
+				if (fstat(map.fd, &st) != 0) return Mapping();
+				size = static_cast<size_t>(st.st_size);
+			}
+
+			void* base = size == 0 ? MAP_FAILED : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, map.fd, 0);
+			if (base == MAP_FAILED) {
+				std::cerr << "Mapping: cannot map shared memory" << std::endl;
+				return Mapping();
+			}
+
+			map.base = base;
+			map.length = size;
+			return std::move(map);
+		}
+#endif
+
+	public:
+		Mapping() = default;
+
+		Mapping(const Mapping&) = delete;
+		Mapping& operator=(const Mapping&) = delete;
+
+		Mapping(Mapping&& other) noexcept {
+			*this = std::move(other);
+		}
+
+		Mapping& operator=(Mapping&& other) noexcept {
+			if (this != &other) {
+				this->release();
+				std::swap(this->base, other.base);
+				std::swap(this->length, other.length);
+#if defined(_WIN32)
+				std::swap(this->file, other.file);
+				std::swap(this->section, other.section);
+				std::swap(this->anonymous, other.anonymous);
+#else
+				std::swap(this->fd, other.fd);
+#endif
+			}
+			return *this;
+		}
+
+		~Mapping() {
+			this->release();
+		}
+
+		static size_t page_size() {
+			static const size_t value = [] {
+#if defined(_WIN32)
+				SYSTEM_INFO info;
+				GetSystemInfo(&info);
+				return static_cast<size_t>(info.dwAllocationGranularity);
+#else
+				return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+			}();
+			return value;
+		}
+
+		/**
+		 * @brief zero-filled private memory, pages are committed lazily by the OS on first touch
+		 */
+		static Mapping anonymous(const size_t size) {
+			Mapping map;
+#if defined(_WIN32)
+			map.base = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			map.anonymous = true;
+#else
+			void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			map.base = base == MAP_FAILED ? nullptr : base;
+#endif
+			if (map.base == nullptr) {
+				std::cerr << "Mapping: anonymous mapping of " << size << " bytes failed." << std::endl;
+				return Mapping();
+			}
+			map.length = size;
+			return map;
+		}
+
+		/**
+		 * @brief map a whole file, size 0 maps its current size, otherwise the file is created or grown to size
+		 * @note copy_on_write at the current size opens the file read-only, so read-only snapshots can be mapped
+		 */
+		static Mapping file(const char* path, const Mode mode, size_t size = 0) {
+			Mapping map;
+			const bool grow = size != 0;
+			const bool writable = grow || mode == Mode::shared;	// private writes never reach the file
+#if defined(_WIN32)
+			map.file = CreateFileA(path, writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+				grow ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (map.file == INVALID_HANDLE_VALUE) {
+				std::cerr << "Mapping: cannot open " << path << std::endl;
+				return Mapping();
+			}
+
+			LARGE_INTEGER current;
+			GetFileSizeEx(map.file, &current);
+			if (!grow) size = static_cast<size_t>(current.QuadPart);
+
+			// the section itself extends the file when it is shorter than size
+			const uint64_t wide = size;
+			map.section = CreateFileMappingA(map.file, nullptr, writable ? PAGE_READWRITE : PAGE_WRITECOPY,
+				static_cast<DWORD>(wide >> 32), static_cast<DWORD>(wide), nullptr);
+			if (size != 0 && map.section != nullptr) {
+				map.base = MapViewOfFile(map.section, mode == Mode::shared ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, size);
+			}
+#else
+			map.fd = open(path, grow ? (O_RDWR | O_CREAT) : writable ? O_RDWR : O_RDONLY, 0644);
+			if (map.fd < 0) {
+				std::cerr << "Mapping: cannot open " << path << std::endl;
+				return Mapping();
+			}
+
+			struct stat st;
+			if (fstat(map.fd, &st) != 0) return Mapping();
+
+			if (!grow) {
+				size = static_cast<size_t>(st.st_size);
+			}
+			else if (static_cast<size_t>(st.st_size) < size && ftruncate(map.fd, static_cast<off_t>(size)) != 0) {
+				std::cerr << "Mapping: cannot grow " << path << " to " << size << " bytes" << std::endl;
+				return Mapping();
+			}
+
+			if (size != 0) {
+				void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, mode == Mode::shared ? MAP_SHARED : MAP_PRIVATE, map.fd, 0);
+				map.base = base == MAP_FAILED ? nullptr : base;
+			}
+#endif
+			if (map.base == nullptr) {
+				std::cerr << "Mapping: cannot map " << path << std::endl;
+				return Mapping();
+			}
+			map.length = size;
+			return map;
+		}
+
+		/**
+		 * @brief named shared memory every process can map (shm_open / a named pagefile section)
+		 * @param create make a new object of size bytes, failing if the name exists; else attach, size 0 = whole object
+		 */
+		static Mapping shared_memory(const char* name, size_t size, const bool create) {
+			Mapping map;
+#if defined(_WIN32)
+			if (create) {
+				const uint64_t wide = size;
+				map.section = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+					static_cast<DWORD>(wide >> 32), static_cast<DWORD>(wide), name);
+				if (map.section != nullptr && GetLastError() == ERROR_ALREADY_EXISTS) {
+					CloseHandle(map.section);
+					map.section = nullptr;
+				}
+			}
+			else {
+				map.section = OpenFileMappingA(FILE_MAP_WRITE, FALSE, name);
+			}
+			if (map.section != nullptr) {
+				map.base = MapViewOfFile(map.section, FILE_MAP_WRITE, 0, 0, size);
+				MEMORY_BASIC_INFORMATION info;
+				if (map.base != nullptr && size == 0 && VirtualQuery(map.base, &info, sizeof(info)) != 0) {
+					size = info.RegionSize;
+				}
+			}
+#else
+			map.fd = shm_open(name, create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0600);
+			if (map.fd >= 0) {
+				return fromDescriptor(std::move(map), size, create);
+			}
+#endif
+			if (map.base == nullptr) {
+				std::cerr << "Mapping: cannot " << (create ? "create" : "open") << " shared memory " << name << std::endl;
+				return Mapping();
+			}
+			map.length = size;
+			return map;
+		}
+
+#if !defined(_WIN32)
+		static void unlink_shared_memory(const char* name) {
+			shm_unlink(name);
+		}
+
+#if defined(__linux__)
+		/**
+		 * @brief anonymous shared memory reachable only through its descriptor (fork, SCM_RIGHTS)
+		 */
+		static Mapping memfd(const char* name, const size_t size) {
+			Mapping map;
+			map.fd = memfd_create(name, MFD_CLOEXEC);
+			if (map.fd < 0) {
+				std::cerr << "Mapping: memfd_create failed" << std::endl;
+				return Mapping();
+			}
+			return fromDescriptor(std::move(map), size, true);
+		}
+#endif
+
+		/**
+		 * @brief map a shared memory descriptor received from another process, the mapping owns a dup of it
+		 */
+		static Mapping attach_descriptor(const int fd) {
+			Mapping map;
+			map.fd = dup(fd);
+			if (map.fd < 0) {
+				std::cerr << "Mapping: cannot duplicate descriptor " << fd << std::endl;
+				return Mapping();
+			}
+			return fromDescriptor(std::move(map), 0, false);
+		}
+
+		int descriptor() const {
+			return this->fd;
+		}
+#endif
+
+		/**
+		 * @brief write [offset, offset + size) of a shared file mapping back to storage and wait for it
+		 * @note offset is rounded down to a page boundary as msync requires; false if it lies past the mapping
+		 */
+		bool sync(size_t offset = 0, size_t size = SIZE_MAX) const {
+			if (this->base == nullptr || offset >= this->length) return false;
+
+			const size_t page = page_size();
+			const size_t begin = offset / page * page;
+			const size_t end = size > this->length - offset ? this->length : offset + size;
+#if defined(_WIN32)
+			if (this->anonymous) return true;
+			return FlushViewOfFile(static_cast<char*>(this->base) + begin, end - begin) != 0 && FlushFileBuffers(this->file) != 0;
+#else
+			if (this->fd < 0) return true;
+			return msync(static_cast<char*>(this->base) + begin, end - begin, MS_SYNC) == 0;
+#endif
+		}
+
+		void* data() const {
+			return this->base;
+		}
+
+		size_t size() const {
+			return this->length;
+		}
+
+		explicit operator bool() const {
+			return this->base != nullptr;
+		}
+	};
+}
@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "./slab.hpp"
+
+namespace slab {
+	namespace detail {
+		template<typename T>
+		struct ParallelWalk {
+			using SlabBlock = typename ObjectPool<T>::SlabBlock;
+
+			template<typename Fn>
+			static void run(ObjectPool<T>& pool, Fn& fn, uint32_t threads) {
+				std::vector<SlabBlock*> slabs;
+				pool.collectSlabs(slabs);
+
+				if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+				threads = static_cast<uint32_t>(std::min<size_t>(threads, slabs.size()));
+				if (threads == 0) return;
+
+				// an exception must not escape a worker (terminate), so each range keeps its own
+				std::vector<std::exception_ptr> errors(threads);
+				auto visit = [&pool, &slabs, &fn, &errors](const uint32_t part, const size_t begin, const size_t end) {
+					auto call = [&fn](void* payload) {
+						fn(*reinterpret_cast<T*>(payload));
+					};
+					try {
+						pool.visitSlabs(slabs.data() + begin, end - begin, call);
+					}
+					catch (...) {
+						errors[part] = std::current_exception();
+					}
+				};
+
+				std::vector<std::thread> workers;
+				workers.reserve(threads - 1);
+
+				// joined on every way out, a joinable std::thread being destroyed would terminate
+				struct Joiner {
+					std::vector<std::thread>& workers;
+
+					~Joiner() {
+						for (std::thread& worker : this->workers) {
+							if (worker.joinable()) worker.join();
+						}
+					}
+				} joiner{ workers };
+
+				const size_t chunk = slabs.size() / threads, extra = slabs.size() % threads;
+				size_t begin = 0;
+
+				for (uint32_t t = 0; t < threads; ++t) {
+					const size_t end = begin + chunk + (t < extra ? 1 : 0);
+					if (t + 1 == threads) {
+						visit(t, begin, end); // the caller takes the last range
+					}
+					else {
+						workers.emplace_back(visit, t, begin, end);
+					}
+					begin = end;
+				}
+
+				for (std::thread& worker : workers) {
+					worker.join();
+				}
+
+				for (const std::exception_ptr& error : errors) {
+					if (error) std::rethrow_exception(error);
+				}
+			}
+		};
+	}
+
+	/**
+	 * @brief ObjectPool::for_each with the slabs split into contiguous ranges across threads
+	 * @param threads worker count including the caller, 0 = hardware concurrency
+	 * @note fn runs concurrently on distinct objects; the pool must not change until this returns.
+	 * Every range runs to its end even if another throws; the first exception is rethrown after all threads joined.
+	 */
+	template<typename T, typename Fn>
+	void for_each_parallel(ObjectPool<T>& pool, Fn&& fn, const uint32_t threads = 0) {
+		detail::ParallelWalk<T>::run(pool, fn, threads);
+	}
+}
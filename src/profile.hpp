@@ -0,0 +1,169 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#if defined(_MSC_VER)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define SLAB_HAS_EXECINFO 1
+#endif
+#if __has_include(<dlfcn.h>) && __has_include(<cxxabi.h>)
+#include <dlfcn.h>
+#include <cxxabi.h>
+#define SLAB_HAS_DLADDR 1
+#endif
+#endif
+
+namespace slab::profile {
+	constexpr auto max_depth = 32;
+
+	/**
+	 * @brief capture the current call stack, innermost frame first
+	 * @return frame count, 0 when the platform has no unwinder
+	 */
+	static inline uint32_t capture(void** frames, const uint32_t depth) {
+#if defined(_MSC_VER)
+		return RtlCaptureStackBackTrace(1, depth, frames, nullptr);
+#elif defined(SLAB_HAS_EXECINFO)
+		const int n = backtrace(frames, static_cast<int>(depth));
+		return n > 0 ? static_cast<uint32_t>(n) : 0;
+#else
+		(void)frames;
+		(void)depth;
+		return 0;
+#endif
+	}
+
+	/**
+	 * @brief function name of a code address, hex address when it cannot be resolved
+	 */
+	static inline std::string symbolize(void* address) {
+#if defined(SLAB_HAS_DLADDR)
+		Dl_info info;
+		if (dladdr(address, &info) != 0 && info.dli_sname != nullptr) {
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+			std::string name = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+			std::free(demangled);
+			return name;
+		}
+#endif
+		char hex[2 + 16 + 1];
+		std::snprintf(hex, sizeof(hex), "0x%llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));
+		return hex;
+	}
+
+	struct Sample {
+		uint32_t size;					// unit size of the sampled allocation
+		uint32_t depth;
+		void* frames[max_depth];
+	};
+
+	/**
+	 * @brief byte-interval sampler with exponentially distributed gaps (as tcmalloc does),
+	 * so every byte has the same chance of being sampled whatever the allocation pattern
+	 */
+	class HeapProfiler {
+	protected:
+		int64_t countdown = INT64_MAX;	// bytes left before the next sample
+		uint64_t interval = 0;			// mean bytes between samples, 0 = off
+		uint64_t state = 0x9E3779B97F4A7C15ULL;
+		std::unordered_map<const void*, Sample> live;
+
+		// xorshift64*, the same generator the benchmark uses
+		uint64_t next_u64() {
+			uint64_t x = this->state;
+			x ^= x << 12;
+			x ^= x >> 25;
+			x ^= x << 27;
+			this->state = x;
+			return x * UINT64_C(2685821657736338717);
+		}
+
+		void resetCountdown() {
+			// uniform in (0, 1], the top 53 bits are exact in a double
+			const double u = (static_cast<double>(this->next_u64() >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+			this->countdown = static_cast<int64_t>(-std::log(u) * static_cast<double>(this->interval)) + 1;
+		}
+
+	public:
+		void set_interval(const uint64_t bytes) {
+			this->interval = bytes;
+			if (bytes == 0) {
+				this->countdown = INT64_MAX;
+			}
+			else {
+				this->resetCountdown();
+			}
+		}
+
+		uint64_t get_interval() const {
+			return this->interval;
+		}
+
+		// hot path: one subtract and a branch per allocation
+		bool tick(const uint32_t size) {
+			this->countdown -= size;
+			return this->countdown <= 0;
+		}
+
+		void record(const void* ptr, const uint32_t size) {
+			this->resetCountdown();
+
+			Sample& sample = this->live[ptr];
+			sample.size = size;
+			sample.depth = capture(sample.frames, max_depth);
+		}
+
+		void drop(const void* ptr) {
+			this->live.erase(ptr);
+		}
+
+		size_t sampled() const {
+			return this->live.size();
+		}
+
+		/**
+		 * @brief live sampled allocations in folded-stack form ("root;...;leaf bytes"),
+		 * bytes scaled up by the inverse sampling probability
+		 */
+		void write_folded(std::ostream& os) const {
+			std::unordered_map<std::string, double> stacks;
+
+			for (const auto& entry : this->live) {
+				const Sample& sample = entry.second;
+				std::string key;
+
+				for (uint32_t i = sample.depth; i > 0; --i) {
+					if (!key.empty()) key += ';';
+					key += symbolize(sample.frames[i - 1]);
+				}
+
+				if (key.empty()) key = "[unknown]";
+
+				const double p = 1.0 - std::exp(-static_cast<double>(sample.size) / static_cast<double>(this->interval));
+				stacks[key] += static_cast<double>(sample.size) / p;
+			}
+
+			for (const auto& stack : stacks) {
+				os << stack.first << ' ' << static_cast<uint64_t>(stack.second + 0.5) << '\n';
+			}
+		}
+	};
+}
@@ -0,0 +1,463 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <filesystem>
+
+#include "./mapping.hpp"
+#include "./slab.hpp"
+
+namespace slab {
+	/**
+	 * @brief first bytes of a region, everything else is found from here by offset
+	 */
+	struct RegionHeader {
+		char magic[8];				// "SLABRG01"
+		uint32_t version;
+		uint32_t unit_size;			// payload bytes per unit, multiple of 8
+		uint64_t capacity;			// region bytes, header included
+		uint32_t slab_capacity;		// slabs that fit in the region
+		uint32_t slab_count;		// slabs carved so far, they never go back
+		uint32_t work;				// slab index of the work list head, region_none if empty
+		uint32_t full;				// slab index of the full list head, region_none if empty
+		uint64_t live;				// allocated units
+		uint64_t root;				// offset the owner stores to find its data again after a reload, 0 = none
+		uint32_t clean;				// 1 while nobody has the region open for writing, else lists and live may be stale
+		uint32_t reserved;
+	};
+
+	/**
+	 * @brief slab header inside a region, links are slab indices so the bytes mean the same at any address
+	 */
+	struct RegionSlab {
+		uint64_t bitMap;			// bit==1 means free
+		uint32_t next;
+		uint32_t prev;
+	};
+
+	constexpr uint32_t region_none = index_list::none;
+	constexpr uint32_t region_version = 2;
+
+	/**
+	 * @brief position-independent slab pool carved from one contiguous region
+	 *
+	 * The region holds a RegionHeader and up to slab_capacity slabs of 64 units. No byte in it is an
+	 * address, so it can be written to a file and mapped back anywhere. Objects kept in it must follow
+	 * the same rule: trivially copyable, referring to each other by offset (offset_of / at).
+	 *
+	 * Persistent regions (open) are a MAP_SHARED file. Only the slab bitmaps and slab_count are
+	 * trusted after a crash; the lists and live count are rebuilt from them by the recovery scan.
+	 */
+	class RegionPool {
+	public:
+		enum class Durability : uint8_t {
+			lazy,	// the kernel writes pages back when it likes, survives a process crash but not a power loss
+			sync,	// every bitmap change is msync'ed before allocate/deallocate return
+		};
+
+	protected:
+		Mapping mapping;
+		bool persistent = false;		// opened MAP_SHARED with open()
+		Durability durability = Durability::lazy;
+		char* base = nullptr;
+		RegionHeader* header = nullptr;
+
+		uint64_t slab_stride = 0;
+		uint64_t slabs_offset = 0;
+
+		static constexpr uint64_t alignUp(const uint64_t value, const uint64_t align) {
+			return (value + align - 1) / align * align;
+		}
+
+		static uint64_t slabStride(const uint32_t unitSize) {
+			return alignUp(sizeof(RegionSlab) + static_cast<uint64_t>(64) * unitSize, 64);
+		}
+
+		static uint64_t slabsOffset() {
+			return alignUp(sizeof(RegionHeader), 64);
+		}
+
+		RegionSlab* slabAt(const uint32_t index) const {
+			return reinterpret_cast<RegionSlab*>(this->base + this->slabs_offset + index * this->slab_stride);
+		}
+
+		char* unitAt(const uint32_t slab, const uint32_t index) const {
+			return reinterpret_cast<char*>(this->slabAt(slab)) + sizeof(RegionSlab) + static_cast<uint64_t>(index) * this->header->unit_size;
+		}
+
+		void unlink(uint32_t& list, const uint32_t index) {
+			index_list::unlink(list, index, [this](const uint32_t i) { return this->slabAt(i); });
+		}
+
+		void pushFront(uint32_t& list, const uint32_t index) {
+			index_list::push_front(list, index, [this](const uint32_t i) { return this->slabAt(i); });
+		}
+
+		bool syncing() const {
+			return this->persistent && this->durability == Durability::sync;
+		}
+
+		void persistSlab(const uint32_t index) const {
+			this->mapping.sync(static_cast<size_t>(this->slabs_offset + index * this->slab_stride), sizeof(RegionSlab));
+		}
+
+		void persistHeader() const {
+			this->mapping.sync(0, sizeof(RegionHeader));
+		}
+
+		// carve the next slab of the region into the work list, false when the region is exhausted
+		bool carve() {
+			if (this->header->slab_count == this->header->slab_capacity) return false;
+
+			// the bitmap must be durable before slab_count makes recovery trust it
+			const uint32_t index = this->header->slab_count;
+			this->slabAt(index)->bitMap = UINT64_MAX;
+			if (this->syncing()) this->persistSlab(index);
+
+			++this->header->slab_count;
+			if (this->syncing()) this->persistHeader();
+
+			this->pushFront(this->header->work, index);
+			return true;
+		}
+
+		/**
+		 * @brief rebuild the lists and the live count from the slab bitmaps
+		 */
+		void recover() {
+			RegionHeader* h = this->header;
+			h->work = region_none;
+			h->full = region_none;
+			h->live = 0;
+
+			// walk backwards so the lowest slabs end up at the list heads
+			for (uint32_t i = h->slab_count; i > 0; --i) {
+				const uint64_t bitMap = this->slabAt(i - 1)->bitMap;
+				h->live += 64 - bits::popcnt64(bitMap);
+				this->pushFront(bitMap == 0 ? h->full : h->work, i - 1);
+			}
+		}
+
+		/**
+		 * @brief slab and unit of a pointer into the region
+		 * @return false if ptr is not the start of a carved unit
+		 */
+		bool locate(const void* ptr, uint32_t& slab, uint32_t& index) const {
+			const char* p = static_cast<const char*>(ptr);
+			if (p < this->base + this->slabs_offset) return false;
+
+			const uint64_t offset = static_cast<uint64_t>(p - this->base) - this->slabs_offset;
+			const uint64_t inside = offset % this->slab_stride;
+			if (offset / this->slab_stride >= this->header->slab_count || inside < sizeof(RegionSlab)) return false;
+
+			const uint64_t unit = inside - sizeof(RegionSlab);
+			if (unit % this->header->unit_size != 0 || unit / this->header->unit_size >= 64) return false;
+
+			slab = static_cast<uint32_t>(offset / this->slab_stride);
+			index = static_cast<uint32_t>(unit / this->header->unit_size);
+			return true;
+		}
+
+		// adopt a mapping that already holds a region, false if the header does not describe it
+		// or its units are not unitSize bytes (0 accepts any); a rejected mapping is left untouched
+		bool attach(Mapping&& map, const uint32_t unitSize = 0) {
+			if (map.size() < sizeof(RegionHeader)) return false;
+
+			const RegionHeader* h = static_cast<const RegionHeader*>(map.data());
+			if (std::memcmp(h->magic, "SLABRG01", 8) != 0 || h->version != region_version) return false;
+			if (h->unit_size == 0 || h->unit_size % 8 != 0 || h->capacity != map.size()) return false;
+			if (unitSize != 0 && h->unit_size != unitSize) return false;
+
+			const uint64_t stride = slabStride(h->unit_size);
+			if (slabsOffset() + h->slab_capacity * stride > h->capacity || h->slab_count > h->slab_capacity) return false;
+			if ((h->work != region_none && h->work >= h->slab_count) || (h->full != region_none && h->full >= h->slab_count)) return false;
+
+			this->mapping = std::move(map);
+			this->base = static_cast<char*>(this->mapping.data());
+			this->header = reinterpret_cast<RegionHeader*>(this->base);
+			this->slab_stride = stride;
+			this->slabs_offset = slabsOffset();
+
+			if (this->header->clean == 0) {
+				this->recover();
+			}
+			return true;
+		}
+
+		void format(const uint32_t unitSize) {
+			RegionHeader* h = this->header;
+			std::memcpy(h->magic, "SLABRG01", 8);
+			h->version = region_version;
+			h->unit_size = unitSize;
+			h->capacity = this->mapping.size();
+			h->slab_capacity = static_cast<uint32_t>((h->capacity - this->slabs_offset) / this->slab_stride);
+			h->slab_count = 0;
+			h->work = region_none;
+			h->full = region_none;
+			h->live = 0;
+			h->root = 0;
+			h->clean = 0;
+			h->reserved = 0;
+		}
+
+		RegionPool() = default;
+
+	public:
+		~RegionPool() {
+			if (this->persistent && this->header != nullptr) {
+				// everything else must be on disk before the region claims to be consistent
+				this->mapping.sync();
+				this->header->clean = 1;
+				this->persistHeader();
+			}
+		}
+
+		RegionPool(const RegionPool&) = delete;
+		RegionPool& operator=(const RegionPool&) = delete;
+
+		RegionPool(RegionPool&&) = delete;
+		RegionPool& operator=(RegionPool&&) = delete;
+
+		/**
+		 * @brief an empty region in anonymous memory
+		 * @param capacity region bytes, rounded up to the page size; pages are only committed when touched
+		 */
+		RegionPool(uint32_t unitSize, const uint64_t capacity) {
+			if (unitSize == 0 || unitSize > slab::unit_max_size) {
+				std::cerr << "Invalid unitSize for RegionPool" << std::endl;
+				exit(1);
+			}
+
+			unitSize = (unitSize + 7) & ~7;// align to 8
+			this->slab_stride = slabStride(unitSize);
+			this->slabs_offset = slabsOffset();
+
+			const uint64_t size = alignUp(std::max<uint64_t>(capacity, this->slabs_offset + this->slab_stride), Mapping::page_size());
+			this->mapping = Mapping::anonymous(static_cast<size_t>(size));
+			if (!this->mapping) {
+				std::cerr << "RegionPool: failed in allocating memory." << std::endl;
+				exit(1);
+			}
+
+			this->base = static_cast<char*>(this->mapping.data());
+			this->header = reinterpret_cast<RegionHeader*>(this->base);
+			this->format(unitSize);
+		}
+
+		/**
+		 * @brief map a snapshot written by save() copy-on-write, nullptr if the file is not a valid region
+		 * @note only the pages that get touched are read, writes never reach the file
+		 */
+		static std::unique_ptr<RegionPool> load(const char* path) {
+			Mapping map = Mapping::file(path, Mapping::Mode::copy_on_write);
+			if (!map) return nullptr;
+
+			std::unique_ptr<RegionPool> pool(new RegionPool());
+			if (!pool->attach(std::move(map))) {
+				std::cerr << "RegionPool: " << path << " is not a valid region snapshot." << std::endl;
+				return nullptr;
+			}
+			return pool;
+		}
+
+		/**
+		 * @brief open or create a persistent region in a MAP_SHARED file
+		 * @param unitSize must match the size the file was created with
+		 * @param capacity size of a new file, ignored for an existing one
+		 * @return nullptr if the file cannot be mapped or holds something else
+		 * @note a file that was not closed cleanly gets the recovery scan; units allocated but never
+		 * linked from the owner's data before a crash stay allocated, sweep them with visit_units
+		 */
+		static std::unique_ptr<RegionPool> open(const char* path, uint32_t unitSize, const uint64_t capacity,
+			const Durability durability = Durability::sync) {
+			unitSize = (unitSize + 7) & ~7;// align to 8
+
+			std::error_code error;
+			const bool fresh = !std::filesystem::exists(path, error) || std::filesystem::file_size(path, error) == 0;
+
+			std::unique_ptr<RegionPool> pool(new RegionPool());
+			pool->persistent = true;
+			pool->durability = durability;
+
+			if (fresh) {
+				if (unitSize == 0 || unitSize > slab::unit_max_size) {
+					std::cerr << "Invalid unitSize for RegionPool" << std::endl;
+					return nullptr;
+				}
+
+				pool->slab_stride = slabStride(unitSize);
+				pool->slabs_offset = slabsOffset();
+				const uint64_t size = alignUp(std::max<uint64_t>(capacity, pool->slabs_offset + pool->slab_stride), Mapping::page_size());
+
+				pool->mapping = Mapping::file(path, Mapping::Mode::shared, static_cast<size_t>(size));
+				if (!pool->mapping) return nullptr;
+
+				pool->base = static_cast<char*>(pool->mapping.data());
+				pool->header = reinterpret_cast<RegionHeader*>(pool->base);
+				pool->format(unitSize);
+				pool->mapping.sync();
+				return pool;
+			}
+
+			Mapping map = Mapping::file(path, Mapping::Mode::shared);
+			if (!map) return nullptr;
+
+			// checked before the recovery scan, which would otherwise rewrite a foreign file's lists
+			if (!pool->attach(std::move(map), unitSize)) {
+				std::cerr << "RegionPool: " << path << " is not a region of " << unitSize << "-byte units." << std::endl;
+				pool->persistent = false; // leave the file as it was
+				return nullptr;
+			}
+
+			// from here on the lists are only kept in memory order, a crash means another scan
+			pool->header->clean = 0;
+			pool->persistHeader();
+			return pool;
+		}
+
+		/**
+		 * @brief write the header and the carved slabs to path, then extend the file to the full capacity
+		 * (a sparse tail) so the loaded pool can keep carving
+		 */
+		bool save(const char* path) const {
+			const uint64_t used = this->slabs_offset + this->header->slab_count * this->slab_stride;
+			{
+				std::ofstream file(path, std::ios::binary | std::ios::trunc);
+				if (!file) {
+					std::cerr << "RegionPool: cannot open " << path << std::endl;
+					return false;
+				}
+
+				// the lists are consistent at this point, so the snapshot loads without a recovery scan
+				RegionHeader snapshot = *this->header;
+				snapshot.clean = 1;
+				file.write(reinterpret_cast<const char*>(&snapshot), sizeof(snapshot));
+				file.write(this->base + sizeof(snapshot), static_cast<std::streamsize>(used - sizeof(snapshot)));
+				if (!file) return false;
+			}
+
+			std::error_code error;
+			std::filesystem::resize_file(path, this->header->capacity, error);
+			return !error;
+		}
+
+		void* allocate() {
+			if (this->header->work == region_none && !this->carve()) {
+				std::cerr << "RegionPool: region is full (" << this->header->slab_capacity << " slabs)." << std::endl;
+				return nullptr;
+			}
+
+			const uint32_t slabIndex = this->header->work;
+			RegionSlab* slab = this->slabAt(slabIndex);
+
+			const uint32_t index = bits::ctz64(slab->bitMap);
+			bits::set_zero(slab->bitMap, static_cast<uint8_t>(index));
+			if (this->syncing()) this->persistSlab(slabIndex);
+			++this->header->live;
+
+			if (slab->bitMap == 0) {
+				this->unlink(this->header->work, slabIndex);
+				this->pushFront(this->header->full, slabIndex);
+			}
+
+			return this->unitAt(slabIndex, index);
+		}
+
+		void deallocate(void* ptr) {
+			uint32_t slabIndex, index;
+			if (ptr == nullptr || !this->locate(ptr, slabIndex, index)) {
+				std::cerr << "deallocate: Invalid pointer for region." << std::endl;
+				return;
+			}
+
+			RegionSlab* slab = this->slabAt(slabIndex);
+			if (bits::get(slab->bitMap, static_cast<uint8_t>(index)) != 0) {
+				std::cerr << "deallocate: Unit is already freed in bitMap." << std::endl;
+				return;
+			}
+
+			const bool wasFull = slab->bitMap == 0;
+			bits::set_one(slab->bitMap, static_cast<uint8_t>(index));
+			if (this->syncing()) this->persistSlab(slabIndex);
+			--this->header->live;
+
+			if (wasFull) {
+				this->unlink(this->header->full, slabIndex);
+				this->pushFront(this->header->work, slabIndex);
+			}
+		}
+
+		/**
+		 * @brief flush [ptr, ptr + size) of a persistent region to storage (no-op otherwise)
+		 * @note write an object, persist it, then persist the link that publishes it; unlink and persist
+		 * before deallocate. That order keeps the owner's data valid whatever point a crash hits.
+		 */
+		void persist(const void* ptr, const size_t size) const {
+			if (this->persistent) {
+				this->mapping.sync(static_cast<size_t>(this->offset_of(ptr)), size);
+			}
+		}
+
+		/**
+		 * @brief call fn(unit) for every allocated unit, e.g. to sweep units a crash left unreachable
+		 */
+		template<typename Fn>
+		void visit_units(Fn&& fn) const {
+			for (uint32_t i = 0; i < this->header->slab_count; ++i) {
+				for (uint64_t live = ~this->slabAt(i)->bitMap; live != 0; live &= live - 1) {
+					fn(static_cast<void*>(this->unitAt(i, bits::ctz64(live))));
+				}
+			}
+		}
+
+		/**
+		 * @brief offset of a pointer into the region, stable across save/load
+		 */
+		uint64_t offset_of(const void* ptr) const {
+			return static_cast<uint64_t>(static_cast<const char*>(ptr) - this->base);
+		}
+
+		template<typename T = void>
+		T* at(const uint64_t offset) const {
+			return offset == 0 ? nullptr : reinterpret_cast<T*>(this->base + offset);
+		}
+
+		/**
+		 * @brief remember where the owner's data starts, read back with root() after load
+		 */
+		void set_root(const void* ptr) {
+			this->header->root = ptr == nullptr ? 0 : this->offset_of(ptr);
+			if (this->syncing()) this->persistHeader();
+		}
+
+		template<typename T = void>
+		T* root() const {
+			return this->at<T>(this->header->root);
+		}
+
+		uint32_t unitSize() const {
+			return this->header->unit_size;
+		}
+
+		uint64_t live() const {
+			return this->header->live;
+		}
+
+		uint32_t slabCount() const {
+			return this->header->slab_count;
+		}
+
+		uint64_t capacity() const {
+			return this->header->capacity;
+		}
+	};
+}
@@ -0,0 +1,166 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string_view>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace slab {
+	class SlabAllocator;
+
+	// limit of allocators registered at the same time
+	constexpr auto registry_capacity = 256;
+	constexpr auto registry_name_size = 48;
+
+	namespace detail {
+		struct RegistrySlot {
+			std::atomic<uint32_t> claimed{ 0 };					// owned by an allocator (name may still be written)
+			std::atomic<const SlabAllocator*> allocator{ nullptr };	// published once name is complete
+			uint32_t object_size;									// sizeof(T) for an ObjectPool, 0 otherwise
+			char name[registry_name_size];
+		};
+
+		inline RegistrySlot registry[registry_capacity];
+		inline std::atomic<uint32_t> registry_readers{ 0 };	// reports in flight
+
+		/**
+		 * @brief claim a slot, copy the name and publish the allocator
+		 * @return slot index, -1 if the registry is full
+		 */
+		inline int32_t registry_add(const SlabAllocator* allocator, const std::string_view name, const uint32_t object_size) {
+			for (int32_t i = 0; i < registry_capacity; ++i) {
+				RegistrySlot& slot = registry[i];
+				uint32_t expected = 0;
+
+				if (slot.claimed.load(std::memory_order_relaxed) == 0 &&
+					slot.claimed.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+					size_t n = 0;
+					for (; n < name.size() && name[n] != '\0' && n + 1 < registry_name_size; ++n) {
+						slot.name[n] = name[n];
+					}
+					slot.name[n] = '\0';
+					slot.object_size = object_size;
+
+					slot.allocator.store(allocator, std::memory_order_release);
+					return i;
+				}
+			}
+
+			return -1;
+		}
+
+		/**
+		 * @brief unpublish a slot and wait until no report can still be reading the allocator
+		 * @note the wait lasts as long as the slowest report in flight, which includes its write(2) calls:
+		 * a report stuck on a full pipe or a slow terminal holds every allocator destructor with it
+		 */
+		inline void registry_remove(const int32_t index) {
+			RegistrySlot& slot = registry[index];
+			slot.allocator.store(nullptr, std::memory_order_seq_cst);
+
+			while (registry_readers.load(std::memory_order_seq_cst) != 0) {
+				// a report is running on another thread, give it the core instead of spinning against it
+#if defined(_WIN32)
+				SwitchToThread();
+#else
+				sched_yield();
+#endif
+			}
+
+			slot.claimed.store(0, std::memory_order_release);
+		}
+
+		/**
+		 * @brief fixed-buffer text writer that only uses write(2), safe inside a signal handler
+		 */
+		class ReportWriter {
+		protected:
+			int fd;
+			size_t used = 0;
+			char buffer[512];
+
+		public:
+			explicit ReportWriter(const int fd) : fd(fd) {}
+
+			~ReportWriter() {
+				this->flush();
+			}
+
+			void flush() {
+				size_t done = 0;
+
+				while (done < this->used) {
+#if defined(_WIN32)
+					const int n = _write(this->fd, this->buffer + done, static_cast<unsigned>(this->used - done));
+#else
+					const ssize_t n = ::write(this->fd, this->buffer + done, this->used - done);
+#endif
+					if (n <= 0) break; // nothing sensible to do from a signal handler
+					done += static_cast<size_t>(n);
+				}
+
+				this->used = 0;
+			}
+
+			void put(const char c) {
+				if (this->used == sizeof(this->buffer)) {
+					this->flush();
+				}
+
+				this->buffer[this->used++] = c;
+			}
+
+			void put(const char* str) {
+				while (*str != '\0') {
+					this->put(*str++);
+				}
+			}
+
+			void put(uint64_t value) {
+				char digits[20];
+				uint32_t n = 0;
+
+				do {
+					digits[n++] = static_cast<char>('0' + value % 10);
+					value /= 10;
+				} while (value != 0);
+
+				while (n > 0) {
+					this->put(digits[--n]);
+				}
+			}
+
+			// JSON string, characters that would need escaping are replaced with '?'
+			void putString(const char* str) {
+				this->put('"');
+				for (; *str != '\0'; ++str) {
+					const char c = *str;
+					this->put((c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) ? '?' : c);
+				}
+				this->put('"');
+			}
+
+			void putField(const char* key, const uint64_t value, const bool first = false) {
+				if (!first) this->put(',');
+				this->putString(key);
+				this->put(':');
+				this->put(value);
+			}
+		};
+	}
+}
@@ -0,0 +1,371 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+
+#include "./mapping.hpp"
+#include "./slab.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SLAB_SPIN_PAUSE() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#define SLAB_SPIN_PAUSE() __builtin_ia32_pause()
+#else
+#define SLAB_SPIN_PAUSE() ((void)0)
+#endif
+
+namespace slab {
+	// the atomics below live in memory mapped by several processes, that only works when they need no lock table
+	static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+		"shared pools need lock-free 32 and 64-bit atomics");
+
+	/**
+	 * @brief first bytes of a shared region, all links are slab indices
+	 */
+	struct SharedHeader {
+		char magic[8];						// "SLABSH01", written last by the creator
+		std::atomic<uint32_t> ready;		// 1 once the creator finished formatting
+		uint32_t unit_size;					// payload bytes per unit, multiple of 8
+		uint64_t capacity;					// region bytes, header included
+		uint32_t slab_capacity;
+		std::atomic<uint32_t> lock;			// spinlock over slab_count and both lists
+		std::atomic<uint32_t> slab_count;	// slabs carved so far, only grows under lock
+		uint32_t work;						// work list head, under lock
+		uint32_t full;						// full list head, under lock
+		uint32_t reserved;
+		std::atomic<uint64_t> live;			// allocated units
+	};
+
+	struct SharedSlab {
+		std::atomic<uint64_t> bitMap;		// bit==1 means free, frees set bits without the lock
+		uint32_t next;						// under lock
+		uint32_t prev;						// under lock
+	};
+
+	/**
+	 * @brief slab pool in shared memory, any attached process may allocate and free
+	 *
+	 * Allocation takes a process-shared spinlock (work list head, carving). A free is one atomic
+	 * fetch_or on the slab bitmap and only takes the lock when it turns a full slab back into a
+	 * work slab. Payloads travel between processes as offsets (offset_of / at), never as pointers.
+	 * @note a process that dies while holding the lock leaves it held
+	 */
+	class SharedPool {
+	protected:
+		Mapping mapping;
+		char* base = nullptr;
+		SharedHeader* header = nullptr;
+		uint64_t slab_stride = 0;
+		uint64_t slabs_offset = 0;
+
+		static constexpr uint64_t alignUp(const uint64_t value, const uint64_t align) {
+			return (value + align - 1) / align * align;
+		}
+
+		static uint64_t slabStride(const uint32_t unitSize) {
+			return alignUp(sizeof(SharedSlab) + static_cast<uint64_t>(64) * unitSize, 64);
+		}
+
+		static uint64_t slabsOffset() {
+			return alignUp(sizeof(SharedHeader), 64);
+		}
+
+		SharedSlab* slabAt(const uint32_t index) const {
+			return reinterpret_cast<SharedSlab*>(this->base + this->slabs_offset + index * this->slab_stride);
+		}
+
+		char* unitAt(const uint32_t slab, const uint32_t index) const {
+			return reinterpret_cast<char*>(this->slabAt(slab)) + sizeof(SharedSlab) + static_cast<uint64_t>(index) * this->header->unit_size;
+		}
+
+		void lock() {
+			std::atomic<uint32_t>& word = this->header->lock;
+			for (uint32_t spins = 0; word.exchange(1, std::memory_order_acquire) != 0;) {
+				while (word.load(std::memory_order_relaxed) != 0) {
+					if (++spins < 64) {
+						SLAB_SPIN_PAUSE();
+					}
+					else {
+						std::this_thread::yield(); // the holder may be another process that got descheduled
+					}
+				}
+			}
+		}
+
+		void unlock() {
+			this->header->lock.store(0, std::memory_order_release);
+		}
+
+		void unlink(uint32_t& list, const uint32_t index) {
+			index_list::unlink(list, index, [this](const uint32_t i) { return this->slabAt(i); });
+		}
+
+		void pushFront(uint32_t& list, const uint32_t index) {
+			index_list::push_front(list, index, [this](const uint32_t i) { return this->slabAt(i); });
+		}
+
+		bool locate(const void* ptr, uint32_t& slab, uint32_t& index) const {
+			const char* p = static_cast<const char*>(ptr);
+			if (p < this->base + this->slabs_offset || p >= this->base + this->header->capacity) return false;
+
+			const uint64_t offset = static_cast<uint64_t>(p - this->base) - this->slabs_offset;
+			const uint64_t inside = offset % this->slab_stride;
+			if (offset / this->slab_stride >= this->header->slab_count.load(std::memory_order_acquire) || inside < sizeof(SharedSlab)) return false;
+
+			const uint64_t unit = inside - sizeof(SharedSlab);
+			if (unit % this->header->unit_size != 0 || unit / this->header->unit_size >= 64) return false;
+
+			slab = static_cast<uint32_t>(offset / this->slab_stride);
+			index = static_cast<uint32_t>(unit / this->header->unit_size);
+			return true;
+		}
+
+		// how long adopt waits for the creator to finish formatting
+		static constexpr std::chrono::milliseconds ready_timeout{ 1000 };
+
+		bool adopt(Mapping&& map) {
+			if (map.size() < sizeof(SharedHeader)) return false;
+
+			const SharedHeader* h = static_cast<const SharedHeader*>(map.data());
+			// the creator may still be formatting; if it died first, or the memory never held a pool, give up
+			const auto deadline = std::chrono::steady_clock::now() + ready_timeout;
+			while (h->ready.load(std::memory_order_acquire) == 0) {
+				if (std::chrono::steady_clock::now() >= deadline) return false;
+				std::this_thread::yield();
+			}
+
+			if (std::memcmp(h->magic, "SLABSH01", 8) != 0 || h->capacity != map.size()) return false;
+			// every other process trusts these for its arithmetic, as RegionPool::attach does its own header
+			if (h->unit_size % 8 != 0 || !validUnitSize(h->unit_size) || h->capacity < slabsOffset()) return false;
+			if (h->slab_capacity != (h->capacity - slabsOffset()) / slabStride(h->unit_size)) return false;
+
+			this->mapping = std::move(map);
+			this->base = static_cast<char*>(this->mapping.data());
+			this->header = reinterpret_cast<SharedHeader*>(this->base);
+			this->slab_stride = slabStride(this->header->unit_size);
+			this->slabs_offset = slabsOffset();
+			return true;
+		}
+
+		bool format(Mapping&& map, const uint32_t unitSize) {
+			if (!map) return false;
+
+			this->mapping = std::move(map);
+			this->base = static_cast<char*>(this->mapping.data());
+			this->header = new (this->base) SharedHeader();
+			this->slab_stride = slabStride(unitSize);
+			this->slabs_offset = slabsOffset();
+
+			SharedHeader* h = this->header;
+			h->unit_size = unitSize;
+			h->capacity = this->mapping.size();
+			h->slab_capacity = static_cast<uint32_t>((h->capacity - this->slabs_offset) / this->slab_stride);
+			h->slab_count.store(0, std::memory_order_relaxed);
+			h->work = slab_none;
+			h->full = slab_none;
+			std::memcpy(h->magic, "SLABSH01", 8);
+			h->ready.store(1, std::memory_order_release);
+			return true;
+		}
+
+		// region bytes for a requested capacity, at least one slab
+		static uint64_t regionSize(const uint32_t unitSize, const uint64_t capacity) {
+			return alignUp(std::max<uint64_t>(capacity, slabsOffset() + slabStride(unitSize)), Mapping::page_size());
+		}
+
+		static bool validUnitSize(const uint32_t unitSize) {
+			if (unitSize == 0 || unitSize > slab::unit_max_size) {
+				std::cerr << "Invalid unitSize for SharedPool" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		SharedPool() = default;
+
+	public:
+		static constexpr uint32_t slab_none = index_list::none;
+
+		SharedPool(const SharedPool&) = delete;
+		SharedPool& operator=(const SharedPool&) = delete;
+
+		SharedPool(SharedPool&&) = delete;
+		SharedPool& operator=(SharedPool&&) = delete;
+
+		/**
+		 * @brief create a named pool (shm_open), nullptr if the name is taken or the mapping fails
+		 */
+		static std::unique_ptr<SharedPool> create(const char* name, uint32_t unitSize, const uint64_t capacity) {
+			unitSize = (unitSize + 7) & ~7;// align to 8
+			if (!validUnitSize(unitSize)) return nullptr;
+
+			std::unique_ptr<SharedPool> pool(new SharedPool());
+			if (!pool->format(Mapping::shared_memory(name, static_cast<size_t>(regionSize(unitSize, capacity)), true), unitSize)) return nullptr;
+			return pool;
+		}
+
+		/**
+		 * @brief attach to a pool another process created by name
+		 */
+		static std::unique_ptr<SharedPool> open(const char* name) {
+			Mapping map = Mapping::shared_memory(name, 0, false);
+			if (!map) return nullptr;
+
+			std::unique_ptr<SharedPool> pool(new SharedPool());
+			if (!pool->adopt(std::move(map))) {
+				std::cerr << "SharedPool: " << name << " is not a shared pool (or its creator never finished formatting it)." << std::endl;
+				return nullptr;
+			}
+			return pool;
+		}
+
+#if defined(__linux__)
+		/**
+		 * @brief create an unnamed pool on a memfd, share it by fork or by sending descriptor() over a socket
+		 */
+		static std::unique_ptr<SharedPool> create_memfd(uint32_t unitSize, const uint64_t capacity) {
+			unitSize = (unitSize + 7) & ~7;// align to 8
+			if (!validUnitSize(unitSize)) return nullptr;
+
+			std::unique_ptr<SharedPool> pool(new SharedPool());
+			if (!pool->format(Mapping::memfd("slab-shared-pool", static_cast<size_t>(regionSize(unitSize, capacity))), unitSize)) return nullptr;
+			return pool;
+		}
+#endif
+
+#if !defined(_WIN32)
+		/**
+		 * @brief attach through a descriptor received from the creating process
+		 */
+		static std::unique_ptr<SharedPool> open_descriptor(const int fd) {
+			Mapping map = Mapping::attach_descriptor(fd);
+			if (!map) return nullptr;
+
+			std::unique_ptr<SharedPool> pool(new SharedPool());
+			if (!pool->adopt(std::move(map))) {
+				std::cerr << "SharedPool: descriptor " << fd << " is not a shared pool (or its creator never finished formatting it)." << std::endl;
+				return nullptr;
+			}
+			return pool;
+		}
+
+		int descriptor() const {
+			return this->mapping.descriptor();
+		}
+#endif
+
+		/**
+		 * @return a unit, nullptr once the region is exhausted
+		 */
+		void* allocate() {
+			this->lock();
+
+			SharedHeader* h = this->header;
+			if (h->work == slab_none) {
+				if (h->slab_count == h->slab_capacity) {
+					this->unlock();
+					std::cerr << "SharedPool: region is full (" << h->slab_capacity << " slabs)." << std::endl;
+					return nullptr;
+				}
+
+				const uint32_t index = h->slab_count.load(std::memory_order_relaxed);
+				this->slabAt(index)->bitMap.store(UINT64_MAX, std::memory_order_relaxed);
+				h->slab_count.store(index + 1, std::memory_order_release);
+				this->pushFront(h->work, index);
+			}
+
+			const uint32_t slabIndex = h->work;
+			SharedSlab* slab = this->slabAt(slabIndex);
+
+			// frees only ever add bits, so the lowest bit seen stays free until this clears it
+			const uint64_t seen = slab->bitMap.load(std::memory_order_relaxed);
+			const uint32_t index = bits::ctz64(seen);
+			const uint64_t bit = static_cast<uint64_t>(1) << index;
+			// acquire pairs with the release of the free that returned this unit, its writes are done
+			const uint64_t after = slab->bitMap.fetch_and(~bit, std::memory_order_acquire) & ~bit;
+
+			if (after == 0) {
+				// a free that sets a bit from here on sees 0 and moves the slab back under the lock
+				this->unlink(h->work, slabIndex);
+				this->pushFront(h->full, slabIndex);
+			}
+
+			this->unlock();
+			h->live.fetch_add(1, std::memory_order_relaxed);
+			return this->unitAt(slabIndex, index);
+		}
+
+		/**
+		 * @brief free a unit from any attached process
+		 */
+		void deallocate(void* ptr) {
+			uint32_t slabIndex, index;
+			if (ptr == nullptr || !this->locate(ptr, slabIndex, index)) {
+				std::cerr << "deallocate: Invalid pointer for shared pool." << std::endl;
+				return;
+			}
+
+			SharedSlab* slab = this->slabAt(slabIndex);
+			const uint64_t bit = static_cast<uint64_t>(1) << index;
+			const uint64_t before = slab->bitMap.fetch_or(bit, std::memory_order_release);
+
+			if ((before & bit) != 0) {
+				std::cerr << "deallocate: Unit is already freed in bitMap." << std::endl;
+				return;
+			}
+
+			this->header->live.fetch_sub(1, std::memory_order_relaxed);
+
+			if (before == 0) {
+				// this free is the first since the slab filled up, so the slab sits in the full list
+				this->lock();
+				this->unlink(this->header->full, slabIndex);
+				this->pushFront(this->header->work, slabIndex);
+				this->unlock();
+			}
+		}
+
+		void deallocate_offset(const uint64_t offset) {
+			this->deallocate(this->base + offset);
+		}
+
+		/**
+		 * @brief offset of a unit, the same in every process that attached the pool
+		 */
+		uint64_t offset_of(const void* ptr) const {
+			return static_cast<uint64_t>(static_cast<const char*>(ptr) - this->base);
+		}
+
+		template<typename T = void>
+		T* at(const uint64_t offset) const {
+			return offset == 0 ? nullptr : reinterpret_cast<T*>(this->base + offset);
+		}
+
+		uint32_t unitSize() const {
+			return this->header->unit_size;
+		}
+
+		uint64_t live() const {
+			return this->header->live.load(std::memory_order_relaxed);
+		}
+
+		uint64_t capacity() const {
+			return this->header->capacity;
+		}
+	};
+}
+
+#undef SLAB_SPIN_PAUSE
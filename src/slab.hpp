@@ -10,8 +10,184 @@
 #include <iostream>
 #include <cassert>
 #include <algorithm>
+#include <cstring>
 
 #include "./bits.hpp"
+#include "./lifecycle.hpp"
+#include "./registry.hpp"
+#include "./typename.hpp"
+
+// set to 1 to compile the statistics counters into every allocator
+#ifndef SLAB_ENABLE_STATS
+#define SLAB_ENABLE_STATS 0
+#endif
+
+#if SLAB_ENABLE_STATS
+#define SLAB_STAT(expr) expr
+#else
+#define SLAB_STAT(expr)
+#endif
+
+// set to 1 to compile in the sampling heap profiler (off until set_sampling_interval is called)
+#ifndef SLAB_ENABLE_PROFILE
+#define SLAB_ENABLE_PROFILE 0
+#endif
+
+#if SLAB_ENABLE_PROFILE
+#define SLAB_PROFILE(expr) expr
+#else
+#define SLAB_PROFILE(expr)
+#endif
+
+// set to 1 to remember each unit's allocation site and report live units at teardown
+#ifndef SLAB_ENABLE_LEAK_CHECK
+#define SLAB_ENABLE_LEAK_CHECK 0
+#endif
+
+#if SLAB_ENABLE_LEAK_CHECK
+#define SLAB_LEAK(expr) expr
+// allocate() must stay a real call so its return address is the caller's site,
+// the ObjectPool wrappers must vanish so that caller is the user's code
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SLAB_CALL_SITE() _ReturnAddress()
+#define SLAB_SITE_NOINLINE __declspec(noinline)
+#define SLAB_SITE_INLINE __forceinline
+#else
+#define SLAB_CALL_SITE() __builtin_return_address(0)
+#define SLAB_SITE_NOINLINE __attribute__((noinline))
+#define SLAB_SITE_INLINE inline __attribute__((always_inline))
+#endif
+#else
+#define SLAB_LEAK(expr)
+#define SLAB_SITE_NOINLINE
+#define SLAB_SITE_INLINE
+#endif
+
+// USDT probes for bpftrace/systemtap, on by default wherever <sys/sdt.h> exists (they are single nops)
+#ifndef SLAB_ENABLE_USDT
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define SLAB_ENABLE_USDT 1
+#endif
+#endif
+#endif
+
+#ifndef SLAB_ENABLE_USDT
+#define SLAB_ENABLE_USDT 0
+#endif
+
+#if SLAB_ENABLE_USDT
+#include <sys/sdt.h>
+#define SLAB_PROBE2(name, a, b) DTRACE_PROBE2(slab, name, a, b)
+#define SLAB_PROBE3(name, a, b, c) DTRACE_PROBE3(slab, name, a, b, c)
+#else
+#define SLAB_PROBE2(name, a, b)
+#define SLAB_PROBE3(name, a, b, c)
+#endif
+
+// set to 1 for a canary after every unit and poison in freed units; it changes the unit layout,
+// so every translation unit of a program must agree on it (NDEBUG does not switch it)
+#ifndef SLAB_ENABLE_GUARD
+#define SLAB_ENABLE_GUARD 0
+#endif
+
+#if SLAB_ENABLE_GUARD
+#define SLAB_GUARD(expr) expr
+#else
+#define SLAB_GUARD(expr)
+#endif
+
+// under AddressSanitizer free and never-used units are poisoned, so pool use-after-free is reported
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SLAB_ASAN 1
+#endif
+#endif
+#if !defined(SLAB_ASAN) && defined(__SANITIZE_ADDRESS__)
+#define SLAB_ASAN 1
+#endif
+
+#if defined(SLAB_ASAN)
+#include <sanitizer/asan_interface.h>
+#define SLAB_ASAN_POISON(addr, size) ASAN_POISON_MEMORY_REGION(addr, size)
+#define SLAB_ASAN_UNPOISON(addr, size) ASAN_UNPOISON_MEMORY_REGION(addr, size)
+#else
+#define SLAB_ASAN_POISON(addr, size) ((void)(addr), (void)(size))
+#define SLAB_ASAN_UNPOISON(addr, size) ((void)(addr), (void)(size))
+#endif
+
+// set to 1 to park freed units in a FIFO for a while before their bits are set free again
+#ifndef SLAB_ENABLE_QUARANTINE
+#define SLAB_ENABLE_QUARANTINE 0
+#endif
+
+// default quarantine budget per allocator in bytes, set_quarantine() changes it at run time
+#ifndef SLAB_QUARANTINE_BYTES
+#define SLAB_QUARANTINE_BYTES (256 * 1024)
+#endif
+
+#if SLAB_ENABLE_QUARANTINE
+#define SLAB_QUARANTINE(expr) expr
+#else
+#define SLAB_QUARANTINE(expr)
+#endif
+
+// set to 1 to hand out a random free unit of the work slab instead of the lowest one
+#ifndef SLAB_ENABLE_RANDOM_UNIT
+#define SLAB_ENABLE_RANDOM_UNIT 0
+#endif
+
+#if SLAB_ENABLE_RANDOM_UNIT
+#include <chrono>
+#endif
+
+// set to 1 to put a per-unit generation tag in the top byte of every returned pointer
+#ifndef SLAB_ENABLE_PTR_TAG
+#define SLAB_ENABLE_PTR_TAG 0
+#endif
+
+// set to 1 to keep a 32-bit generation per unit, checked by generational Handles
+#ifndef SLAB_ENABLE_GENERATIONS
+#define SLAB_ENABLE_GENERATIONS 0
+#endif
+
+// set to 1 for the slab table behind 32-bit UnitHandles (forced on by SLAB_ENABLE_PTR_TAG and SLAB_ENABLE_GENERATIONS)
+#ifndef SLAB_ENABLE_HANDLES
+#define SLAB_ENABLE_HANDLES 0
+#endif
+
+#if SLAB_ENABLE_PTR_TAG || SLAB_ENABLE_GENERATIONS
+#undef SLAB_ENABLE_HANDLES
+#define SLAB_ENABLE_HANDLES 1
+#endif
+
+// set to 1 to time every allocate/deallocate with rdtscp and charge it to the path taken
+#ifndef SLAB_ENABLE_CYCLES
+#define SLAB_ENABLE_CYCLES 0
+#endif
+
+#if SLAB_ENABLE_CYCLES
+#include "./cycles.hpp"
+#define SLAB_CYCLES(expr) expr
+#else
+#define SLAB_CYCLES(expr)
+#endif
+
+#if SLAB_ENABLE_PROFILE || SLAB_ENABLE_LEAK_CHECK
+#include "./profile.hpp"
+#endif
+
+#include <vector>
+
+#if defined(__clang__) || defined(__GNUC__)
+#define SLAB_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define SLAB_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#else
+#define SLAB_PREFETCH(addr) ((void)(addr))
+#endif
 
 namespace slab {
 #if defined(__clang__) || defined(__GNUC__)  
@@ -23,13 +199,113 @@ namespace slab {
 
 	// limit size
 	constexpr auto unit_max_size = 4096;
-	static void* (*_malloc)(size_t size) = std::malloc;
-	static void (*_free)(void*) = std::free;
+
+#if SLAB_ENABLE_PTR_TAG
+	static_assert(sizeof(void*) == 8, "pointer tags need 64-bit pointers");
+#endif
+
+	// top byte of a pool pointer, the unit's generation tag when SLAB_ENABLE_PTR_TAG is set
+	static inline uint8_t pointer_tag(const void* ptr) {
+#if SLAB_ENABLE_PTR_TAG
+		return static_cast<uint8_t>(reinterpret_cast<uintptr_t>(ptr) >> 56);
+#else
+		(void)ptr;
+		return 0;
+#endif
+	}
+
+	/**
+	 * @brief strip the pointer tag before dereferencing (identity unless SLAB_ENABLE_PTR_TAG)
+	 * @note AArch64 ignores the top byte in hardware (TBI); x86-64 faults on it, so tagged pointers
+	 * must pass through untag() there. User addresses are assumed to fit in 56 bits.
+	 */
+	template<typename T>
+	static inline T* untag(T* ptr) {
+#if SLAB_ENABLE_PTR_TAG
+		return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(ptr) & ((static_cast<uintptr_t>(1) << 56) - 1));
+#else
+		return ptr;
+#endif
+	}
+
+	// 32-bit name of a unit: (slab table slot << 6) | unit index
+	using UnitHandle = uint32_t;
+	constexpr UnitHandle invalid_handle = UINT32_MAX;
+
+	/**
+	 * @brief UnitHandle plus the unit's generation when it was issued (odd = live), stale once the unit is freed
+	 */
+	struct Handle {
+		UnitHandle index = invalid_handle;
+		uint32_t generation = 0;
+
+		bool operator==(const Handle& other) const {
+			return this->index == other.index && this->generation == other.generation;
+		}
+
+		bool operator!=(const Handle& other) const {
+			return !(*this == other);
+		}
+	};
+
+	struct SlabStats {
+		uint64_t allocations = 0;		// successful allocate calls
+		uint64_t deallocations = 0;		// successful deallocate calls
+		uint64_t slab_creates = 0;		// slabs obtained from _malloc
+		uint64_t slab_destroys = 0;		// slabs returned to _free (teardown excluded)
+		uint64_t work_to_full = 0;		// work -> full list moves
+		uint64_t full_to_work = 0;		// full -> work list moves
+		uint64_t double_frees = 0;		// deallocate on a unit that is already free
+		uint64_t invalid_frees = 0;		// nullptr, bad index or foreign allocator
+		uint64_t live_units = 0;		// units currently allocated
+		uint64_t peak_live_units = 0;	// high-water mark of live_units
+		uint64_t peak_slabs = 0;		// high-water mark of total slab count
+	};
+
+	struct SlabSnapshot {
+		uint32_t unit_size = 0;			// usable bytes per unit
+		uint64_t slab_bytes = 0;		// bytes of one slab including metadata
+		uint32_t total_slabs = 0;
+		uint32_t work_slabs = 0;		// slabs with at least one free unit
+		uint32_t full_slabs = 0;
+		uint32_t empty_slabs = 0;		// reserved slabs without live units
+		uint64_t live_units = 0;
+		uint64_t bytes_in_use = 0;		// live_units * unit_size
+		uint64_t bytes_reserved = 0;	// total_slabs * slab_bytes
+		uint32_t occupancy[65] = {};	// slab count by live units (0..64)
+
+		void write_json(std::ostream& os) const {
+			os << "{\"unit_size\":" << this->unit_size
+				<< ",\"slab_bytes\":" << this->slab_bytes
+				<< ",\"slabs\":{\"total\":" << this->total_slabs
+				<< ",\"work\":" << this->work_slabs
+				<< ",\"full\":" << this->full_slabs
+				<< ",\"empty\":" << this->empty_slabs
+				<< "},\"live_units\":" << this->live_units
+				<< ",\"bytes\":{\"in_use\":" << this->bytes_in_use
+				<< ",\"reserved\":" << this->bytes_reserved
+				<< "},\"occupancy\":[";
+
+			for (uint32_t i = 0; i <= 64; ++i) {
+				os << (i ? "," : "") << this->occupancy[i];
+			}
+
+			os << "]}";
+		}
+	};
+
+	void report(const int fd = 2);
 
 	class SlabAllocator {
+		friend void report(const int fd);
 	protected:
 		struct alignas(8) SlabUnit {
+#if SLAB_ENABLE_PTR_TAG
+			uint32_t index : 6;			// 0-63
+			uint32_t slot : 26;			// the slab's table slot, deallocate resolves the slab through the table
+#else
 			uint32_t index;				// only need 0-63
+#endif
 			uint32_t offset;			// the offset to SlabBlock
 			char payload[];
 
@@ -51,7 +327,25 @@ namespace slab {
 			SlabBlock* next;			// next slab in the list
 			SlabBlock* prev;			// prev slab in the list
 			uint64_t bitMap;			// bit==1 means free (bitMap != 0)
-			char payload[];				// the slices
+#if SLAB_ENABLE_HANDLES
+			uint32_t slot;				// index in the allocator's slab table, the high bits of a UnitHandle
+#endif
+#if SLAB_ENABLE_PROFILE
+			uint64_t sampledMap;		// bit==1 means the unit holds a profiler sample
+#endif
+#if SLAB_ENABLE_GENERATIONS
+			uint32_t generations[64];	// odd = allocated, bumped on allocate and on free
+#endif
+#if SLAB_ENABLE_PTR_TAG
+			uint8_t tags[64];			// generation of each unit, bumped on every allocation, never 0
+#endif
+#if SLAB_ENABLE_QUARANTINE
+			uint64_t quarantineMap;		// bit==1 means the unit is freed but still parked in the quarantine
+#endif
+#if SLAB_ENABLE_LEAK_CHECK
+			void* sites[64];			// return address of the allocate() call per unit
+#endif
+			alignas(8) char payload[];	// the slices, 8-aligned whatever the optional fields above add up to
 
 			SlabBlock() = delete;
 			~SlabBlock() = delete;
@@ -66,15 +360,21 @@ namespace slab {
 				_this->prev = nullptr;
 				_this->next = nullptr;
 				_this->bitMap = UINT64_MAX; // all free
+				SLAB_PROFILE(_this->sampledMap = 0);
+				SLAB_QUARANTINE(_this->quarantineMap = 0);
 
 				for (size_t i = 0; i < 64; ++i) {
 					const auto currentOffset = baseOffset + i * allocator->unitMetaSize;
 					SlabUnit* unit = (SlabUnit*)(reinterpret_cast<char*>(_this) + currentOffset);
 					SlabUnit::construct(unit, i, currentOffset);
+					SLAB_GUARD(allocator->guardFree(unit));
+					// the SlabUnit header stays addressable, deallocate reads it for any pointer
+					SLAB_ASAN_POISON(unit->payload, allocator->unitMetaSize - sizeof(SlabUnit));
 				}
 			}
 
 			static void destroy(SlabBlock* _this) {
+				SLAB_ASAN_UNPOISON(_this, SlabBlock::byteSize(_this->allocator->unitMetaSize));
 				_free(_this);
 			}
 
@@ -97,25 +397,37 @@ namespace slab {
 				return (SlabUnit*)((char*)this->payload + index * unitMetaSize);
 			}
 
-			SlabUnit* allocateUnit(const size_t unitMetaSize) {
+			SlabUnit* allocateUnit(const size_t unitMetaSize, const uint64_t random) {
 				assert(!this->isFull() && "SlabBlock is full, cannot allocate unit.");
 
+#if SLAB_ENABLE_RANDOM_UNIT
+				// scale the top 32 random bits to [0, free units) without a division
+				const uint32_t rank = static_cast<uint32_t>(((random >> 32) * bits::popcnt64(this->bitMap)) >> 32);
+				uint32_t index = bits::select64(this->bitMap, rank);
+#else
+				(void)random;
 				uint32_t index = bits::ctz64(this->bitMap);
+#endif
 				bits::set_zero(this->bitMap, index);
-				return (SlabUnit*)((char*)this->payload + index * unitMetaSize);
+#if SLAB_ENABLE_GENERATIONS
+				++this->generations[index];
+#endif
+
+				SlabUnit* unit = (SlabUnit*)((char*)this->payload + index * unitMetaSize);
+				// the canary stays poisoned, ASan then also catches overflows into it
+				SLAB_ASAN_UNPOISON(unit->payload, unitMetaSize - sizeof(SlabUnit) - SlabAllocator::unit_guard_size);
+				return unit;
 			}
 
-			void deallocateUnit(const uint32_t index) {
+			void deallocateUnit(const size_t unitMetaSize, const uint32_t index) {
 				bits::set_one(this->bitMap, index);
+				SLAB_ASAN_POISON(this->getUnitByIndex(unitMetaSize, index)->payload, unitMetaSize - sizeof(SlabUnit));
 			}
 
 			static SlabBlock* create(const SlabAllocator* allocator) {
-				// Calculate the offset of the 'payload' flexible array member in SlabBlock.
 				// Allocate memory for the fixed part of the structure plus space for 64 units of metadata.
 				// This ensures the flexible array can be used safely without additional allocations.
-				constexpr size_t baseOffset = OFFSET_OF(SlabBlock, payload);
-
-				SlabBlock* slab = (SlabBlock*)_malloc(baseOffset + (static_cast<size_t>(64) * allocator->unitMetaSize));
+				SlabBlock* slab = (SlabBlock*)_malloc(SlabBlock::byteSize(allocator->unitMetaSize));
 
 				if (slab != nullptr) {
 					SlabBlock::construct(slab, allocator);
@@ -130,40 +442,403 @@ namespace slab {
 				return (SlabBlock*)((char*)unit - unit->offset);
 			}
 
-			static void print_bitMap(uint64_t bitMap) {
-				static const char* bins[16] = {
-					"####","###_","##_#","##__",
-					"#_##","#_#_","#__#","#___",
-					"_###","_##_","_#_#","_#__",
-					"__##","__#_","___#","____"
-				};
-
-				for (uint32_t i = 0; i < 4; ++i) {
-					std::cout << bins[(bitMap >> 12) & 0xf] << bins[(bitMap >> 8) & 0xf] << bins[(bitMap >> 4) & 0xf] << bins[bitMap & 0xf] << std::endl;
-					bitMap >>= 16;
-				}
+			static size_t byteSize(const size_t unitMetaSize) {
+				return OFFSET_OF(SlabBlock, payload) + static_cast<size_t>(64) * unitMetaSize;
 			}
 		};
 	protected:
 		SlabBlock* work = nullptr;
 		SlabBlock* full = nullptr;
 
-		uint32_t unitMetaSize = 0;		// sizeof unit payload + meta
+		uint32_t unitMetaSize = 0;		// sizeof unit payload + meta (+ canary)
 		uint32_t total_count = 0;		// total slab count
+		uint32_t full_count = 0;		// slab count in full list
 		uint32_t reserved_count;		// reserved free slab count
 		uint32_t reserved_limit;		// reserved free slab limit
+		int32_t registry_index = -1;	// slot in the global registry, -1 if not registered
+
+#if SLAB_ENABLE_HANDLES
+		static constexpr uint32_t slab_table_limit = 1u << 26;	// slots a UnitHandle can name
+		// what a slot keeps from its destroyed slab: the next slab there starts past every name issued before
+		struct SlotMemo {
+#if SLAB_ENABLE_GENERATIONS
+			uint32_t generation;	// newest generation of the old slab
+#endif
+#if SLAB_ENABLE_PTR_TAG
+			uint8_t tag;			// newest pointer tag of the old slab
+#endif
+		};
+		SlotTable<SlabBlock, SlotMemo> slab_table;	// UnitHandle >> 6 -> slab
+#endif
+
+		// a slab created shortly after one was destroyed means reserved_limit is too tight for the workload
+		static constexpr uint32_t churn_window = 16;		// slab events from destroy to create that count as churn
+		static constexpr uint32_t churn_decay = 1u << 14;	// allocate/deallocate calls without the boost being used before it halves
+		static constexpr uint32_t churn_boost_max = 16;	// extra reserved slabs churn detection may grant
+
+		uint64_t churn_clock = 0;		// slab events: create, destroy, work <-> full moves
+		uint64_t churn_destroyed = 0;	// churn_clock at the last destroy, 0 = never
+		uint32_t churn_idle = 0;		// calls left before the boost halves, reset whenever the boost is used
+		uint32_t reserved_boost = 0;	// extra reserved slabs on top of reserved_limit
+		bool adaptive_reserve = false;
+
+#if SLAB_ENABLE_STATS
+		// own cache line, so allocators owned by different threads never share it
+		alignas(64) SlabStats counters;
+		uint32_t occupancy[65] = {};	// slab count by live units, kept in step with every bitMap change
+
+		void statAllocate() {
+			++this->counters.allocations;
+			if (++this->counters.live_units > this->counters.peak_live_units) {
+				this->counters.peak_live_units = this->counters.live_units;
+			}
+		}
+
+		void statDeallocate() {
+			++this->counters.deallocations;
+			--this->counters.live_units;
+		}
+
+		void statOccupancy(const SlabBlock* slab, const int32_t delta) {
+			const uint32_t live = 64 - bits::popcnt64(slab->bitMap);
+			--this->occupancy[live - delta];
+			++this->occupancy[live];
+		}
+
+		void statSlabCount() {
+			if (this->total_count > this->counters.peak_slabs) {
+				this->counters.peak_slabs = this->total_count;
+			}
+		}
+#endif
+
+#if SLAB_ENABLE_CYCLES
+		cycles::CycleStats cycle_counters;
+#endif
+
+		enum class Release : uint8_t {
+			fast,		// only the bit changed
+			to_work,	// slab moved from full to work
+			destroy		// slab became empty beyond the reserve and was destroyed
+		};
+
+		/**
+		 * @brief give a unit back to its slab's bitMap and fix up the lists
+		 */
+		Release releaseUnit(SlabBlock* slab, const SlabUnit* unit) {
+			bool isFull = slab->isFull();
+			slab->deallocateUnit(this->unitMetaSize, unit->index);
+			SLAB_STAT(this->statOccupancy(slab, -1));
+
+			if (isFull) {
+				this->moveFromFullToWork(slab);
+				return Release::to_work;
+			}
+
+			if (slab->isEmpty()) {
+				// it's free now
+				++this->reserved_count;
+				if (this->reserved_count > this->reserve_limit()) {
+					this->removeFromWorkAndDestroy(slab);
+					return Release::destroy;
+				}
+			}
+
+			return Release::fast;
+		}
+
+#if SLAB_ENABLE_QUARANTINE
+		SlabUnit** quarantine_ring = nullptr;	// FIFO of parked units
+		uint32_t quarantine_capacity = 0;		// budget / unitMetaSize, 0 = off
+		uint32_t quarantine_head = 0;			// oldest entry
+		uint32_t quarantine_size = 0;
+		uint32_t quarantine_slabs = 0;			// slabs with at least one parked unit
+		uint32_t quarantine_slab_limit = 0;		// budget / slab bytes, at least 1
+
+		// release the oldest parked unit to its slab
+		void quarantineEvict() {
+			SlabUnit* unit = this->quarantine_ring[this->quarantine_head];
+			SlabBlock* slab = SlabBlock::getBlockFromUnit(unit);
+			this->quarantine_head = (this->quarantine_head + 1) % this->quarantine_capacity;
+			--this->quarantine_size;
+
+			bits::set_zero(slab->quarantineMap, unit->index);
+			if (slab->quarantineMap == 0) --this->quarantine_slabs;
+			// the poison must have survived the whole stay
+			SLAB_ASAN_UNPOISON(unit->payload, this->unitSize());
+			SLAB_GUARD(this->guardAllocate(unit));
+			this->releaseUnit(slab, unit);
+		}
+
+		/**
+		 * @brief park a freed unit, evicting the oldest ones while either budget is exceeded
+		 */
+		void quarantinePush(SlabBlock* slab, SlabUnit* unit) {
+			SLAB_ASAN_POISON(unit->payload, this->unitMetaSize - sizeof(SlabUnit));
+			if (slab->quarantineMap == 0) ++this->quarantine_slabs;
+			bits::set_one(slab->quarantineMap, unit->index);
+
+			if (this->quarantine_size == this->quarantine_capacity) {
+				this->quarantineEvict();
+			}
+			this->quarantine_ring[(this->quarantine_head + this->quarantine_size) % this->quarantine_capacity] = unit;
+			++this->quarantine_size;
+
+			// one parked unit keeps its whole slab from being destroyed, so slabs are what the budget bounds
+			while (this->quarantine_slabs > this->quarantine_slab_limit) {
+				this->quarantineEvict();
+			}
+		}
+
+		void quarantineDrain() {
+			while (this->quarantine_size != 0) {
+				this->quarantineEvict();
+			}
+			this->quarantine_head = 0;
+		}
+#endif
+
+#if SLAB_ENABLE_RANDOM_UNIT
+		uint64_t random_state = 0;
+
+		static uint64_t randomSeed(const void* salt) {
+			// splitmix64 of the allocator address and the clock, so allocators and runs differ
+			uint64_t z = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(salt)) ^
+				static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+			z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+			z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+			z ^= z >> 31;
+			return z != 0 ? z : UINT64_C(0x9E3779B97F4A7C15);
+		}
+#endif
+
+		// random bits for the unit choice, always 0 unless SLAB_ENABLE_RANDOM_UNIT
+		uint64_t unitRandom() {
+#if SLAB_ENABLE_RANDOM_UNIT
+			// xorshift64*
+			uint64_t x = this->random_state;
+			x ^= x << 12;
+			x ^= x >> 25;
+			x ^= x << 27;
+			this->random_state = x;
+			return x * UINT64_C(2685821657736338717);
+#else
+			return 0;
+#endif
+		}
+
+		// the pointer handed to the user: the payload with the unit's next generation in the top byte
+		static void* tagUnit(SlabBlock* slab, void* mem) {
+#if SLAB_ENABLE_PTR_TAG
+			const uint32_t index = SlabUnit::getUnitFromPayload(mem)->index;
+			if (++slab->tags[index] == 0) {
+				slab->tags[index] = 1; // 0 is what an untagged pointer carries
+			}
+#endif
+			return withTag(slab, mem);
+		}
+
+		// the payload with the unit's current tag, what allocate returned for it
+		static void* withTag(const SlabBlock* slab, void* mem) {
+#if SLAB_ENABLE_PTR_TAG
+			const uint8_t tag = slab->tags[SlabUnit::getUnitFromPayload(mem)->index];
+			return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(mem) | (static_cast<uintptr_t>(tag) << 56));
+#else
+			(void)slab;
+			return mem;
+#endif
+		}
+
+		// bytes appended to every unit for the canary
+		static constexpr uint32_t unit_guard_size = SLAB_ENABLE_GUARD ? 8 : 0;
+
+#if SLAB_ENABLE_GUARD
+		static constexpr uint64_t guard_poison = 0xDDDDDDDDDDDDDDDDULL;	// freed payload pattern
+		static constexpr uint64_t guard_canary = 0x5AB5AB5AB5AB5AB5ULL;	// mixed with the unit address
+
+		uint64_t guardCanary(const SlabUnit* unit) const {
+			return guard_canary ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(unit));
+		}
+
+		[[noreturn]] void guardFail(const SlabUnit* unit, const char* what, const uint32_t offset) const {
+			std::cerr << "slabAllocator: " << what << " in unit " << static_cast<const void*>(unit->payload)
+				<< " at byte " << offset << " (unit size " << this->unitSize() << ")" << std::endl;
+			std::abort();
+		}
+
+		void guardCheckCanary(const SlabUnit* unit) const {
+			uint64_t canary;
+			SLAB_ASAN_UNPOISON(unit->payload + this->unitSize(), sizeof(canary));
+			std::memcpy(&canary, unit->payload + this->unitSize(), sizeof(canary));
+			SLAB_ASAN_POISON(unit->payload + this->unitSize(), sizeof(canary));
+			if (canary != this->guardCanary(unit)) {
+				this->guardFail(unit, "overflow past the end (canary smashed)", this->unitSize());
+			}
+		}
+
+		// fill a freed unit with poison and (re)write its canary
+		void guardFree(SlabUnit* unit) const {
+			const uint64_t canary = this->guardCanary(unit);
+			std::memset(unit->payload, static_cast<int>(guard_poison & 0xff), this->unitSize());
+			SLAB_ASAN_UNPOISON(unit->payload + this->unitSize(), sizeof(canary));
+			std::memcpy(unit->payload + this->unitSize(), &canary, sizeof(canary));
+		}
+
+		// a unit about to be handed out must still be poisoned, anything else was written after free
+		void guardAllocate(const SlabUnit* unit) const {
+			for (uint32_t offset = 0; offset < this->unitSize(); offset += 8) {
+				uint64_t word;
+				std::memcpy(&word, unit->payload + offset, sizeof(word));
+				if (word != guard_poison) {
+					this->guardFail(unit, "write after free", offset);
+				}
+			}
+			this->guardCheckCanary(unit);
+		}
+#endif
+
+		bool registerEntry(const std::string_view name, const uint32_t object_size) {
+			this->unregister();
+			this->registry_index = detail::registry_add(this, name, object_size);
+			return this->registry_index >= 0;
+		}
+
+		void churnCreate() {
+			if (this->adaptive_reserve && this->churn_destroyed != 0 && this->churn_clock - this->churn_destroyed <= churn_window) {
+				this->churn_idle = churn_decay;
+				if (this->reserved_boost < churn_boost_max) {
+					++this->reserved_boost;
+				}
+			}
+		}
+
+		// once per allocate/deallocate: the boost halves after churn_decay calls that did not need it
+		void churnTick() {
+			if (this->reserved_boost != 0 && --this->churn_idle == 0) {
+				this->reserved_boost >>= 1;
+				this->churn_idle = churn_decay;
+				this->trimReserve();
+			}
+		}
+
+		// destroy empty slabs beyond reserve_limit(), left over after the limit dropped
+		void trimReserve() {
+			// trimming is not churn, a create right after it must not count as one
+			const uint64_t destroyed = this->churn_destroyed;
+			uint32_t n = this->total_count - this->full_count;
+			SlabBlock* slab = this->work;
+
+			while (n-- != 0 && this->reserved_count > this->reserve_limit()) {
+				SlabBlock* next = slab->next;
+				if (slab->isEmpty()) {
+					this->removeFromWorkAndDestroy(slab);
+				}
+				slab = next;
+			}
+
+			this->churn_destroyed = destroyed;
+		}
+
+#if SLAB_ENABLE_PROFILE
+		profile::HeapProfiler profiler;
+
+		void profileAllocate(SlabBlock* slab, void* mem) {
+			if (this->profiler.tick(this->unitSize())) {
+				this->profiler.record(mem, this->unitSize());
+				bits::set_one(slab->sampledMap, SlabUnit::getUnitFromPayload(mem)->index);
+			}
+		}
+
+		void profileDeallocate(SlabBlock* slab, const SlabUnit* unit) {
+			if (bits::get(slab->sampledMap, unit->index)) {
+				bits::set_zero(slab->sampledMap, unit->index);
+				this->profiler.drop(unit->payload);
+			}
+		}
+#endif
+
+#if SLAB_ENABLE_LEAK_CHECK
+		static void leakRecord(SlabBlock* slab, void* mem, void* site) {
+			slab->sites[SlabUnit::getUnitFromPayload(mem)->index] = site;
+		}
+
+		static void leakCollect(const SlabBlock* begin, std::unordered_map<void*, uint64_t>& sites) {
+			const SlabBlock* slab = begin;
+
+			do {
+				for (uint32_t i = 0; i < 64; ++i) {
+					if (slab->isUnitAllocated(i)) {
+						++sites[slab->sites[i]];
+					}
+				}
+				slab = slab->next;
+			} while (slab != begin);
+		}
+
+		/**
+		 * @brief print live units grouped by allocation site to std::cerr, largest first
+		 */
+		void leakReport() const {
+			std::unordered_map<void*, uint64_t> bySite;
+
+			if (this->full != nullptr) leakCollect(this->full, bySite);
+			if (this->work != nullptr) leakCollect(this->work, bySite);
+			if (bySite.empty()) return;
+
+			std::vector<std::pair<void*, uint64_t>> sites(bySite.begin(), bySite.end());
+			uint64_t units = 0;
+			for (const auto& entry : sites) units += entry.second;
+
+			std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+			std::cerr << "slabAllocator: " << units << " live units (" << units * this->unitSize() << " bytes) at teardown";
+			if (this->registry_index >= 0) {
+				std::cerr << " of \"" << detail::registry[this->registry_index].name << "\"";
+			}
+			std::cerr << std::endl;
+
+			for (const auto& entry : sites) {
+				std::cerr << "  " << entry.second << " units, " << entry.second * this->unitSize() << " bytes from "
+					<< profile::symbolize(entry.first) << " [" << entry.first << "]" << std::endl;
+			}
+		}
+#endif
 
 	protected:
 		/**
 		 * @brief create a block for work
 		 */
-		SlabBlock* makeBlock() const {
+		SlabBlock* makeBlock() {
 			SlabBlock* slab = SlabBlock::create(this);
 			if (slab == nullptr) {
+				SLAB_PROBE2(oom, this, SlabBlock::byteSize(this->unitMetaSize));
 				std::cerr << "slabAllocator: failed in allocating memory." << std::endl;
 				exit(1);
 			}
 
+#if SLAB_ENABLE_HANDLES
+			slab->slot = this->slab_table.acquire(slab, slab_table_limit);
+			if (slab->slot == SlotTable<SlabBlock, SlotMemo>::none) {
+				std::cerr << "slabAllocator: slab table is full or out of memory, UnitHandle cannot name more slabs." << std::endl;
+				exit(1);
+			}
+#endif
+#if SLAB_ENABLE_GENERATIONS
+			std::fill(std::begin(slab->generations), std::end(slab->generations), this->slab_table.tag(slab->slot).generation);
+#endif
+#if SLAB_ENABLE_PTR_TAG
+			// a recreated slab is usually at the old address, tags starting at 0 would make stale pointers valid again
+			std::memset(slab->tags, this->slab_table.tag(slab->slot).tag, sizeof(slab->tags));
+			for (uint32_t i = 0; i < 64; ++i) {
+				slab->getUnitByIndex(this->unitMetaSize, i)->slot = slab->slot;
+			}
+#endif
+
+			SLAB_STAT(++this->counters.slab_creates);
+			SLAB_PROBE3(slab_create, this, slab, this->total_count + 1);
+			++this->churn_clock;
+			SLAB_STAT(++this->occupancy[0]);
+
 			slab->next = slab; // link as a circle
 			slab->prev = slab; // link as a circle
 			return slab;
@@ -180,90 +855,92 @@ namespace slab {
 		}
 
 		void moveFromWorkToFull(SlabBlock* slab) {
-			//remove head from work
-			if (slab->next != slab) {
-				this->work = this->work->next;
-				this->work->prev = slab->prev;
-				slab->prev->next = this->work;
-			}
-			else {
-				this->work = nullptr;
-			}
-
-			//move into full
-			if (this->full != nullptr) {
-				slab->next = this->full;
-				slab->prev = this->full->prev;
-				slab->next->prev = slab;
-				slab->prev->next = slab;
+			SLAB_STAT(++this->counters.work_to_full);
+			SLAB_PROBE2(work_to_full, this, slab);
+			++this->churn_clock;
+			++this->full_count;
 
-				this->full = slab;
-			}
-			else {
-				slab->next = slab;
-				slab->prev = slab;
-
-				this->full = slab;
-			}
+			list::unlink(this->work, slab);
+			list::push_front(this->full, slab);
 		}
 
 		void moveFromFullToWork(SlabBlock* slab) {
-			//remove from full
-			if (slab != this->full) {
-				slab->prev->next = slab->next;
-				slab->next->prev = slab->prev;
-			}
-			else {
-				if (slab->next != slab) {
-					slab->prev->next = slab->next;
-					slab->next->prev = slab->prev;
-					this->full = slab->next;
-				}
-				else {
-					this->full = nullptr;
-				}
-			}
-			//move to work head
-			if (this->work != nullptr) {
-				slab->next = this->work;
-				slab->prev = this->work->prev;
-				slab->next->prev = slab;
-				slab->prev->next = slab;
-
-				this->work = slab;
-			}
-			else {
-				slab->next = slab;
-				slab->prev = slab;
-
-				this->work = slab;
-			}
+			SLAB_STAT(++this->counters.full_to_work);
+			SLAB_PROBE2(full_to_work, this, slab);
+			++this->churn_clock;
+			assert(this->full_count > 0 && "Invalid full count.");
+			--this->full_count;
+
+			list::unlink(this->full, slab);
+			list::push_front(this->work, slab);
 		}
 
 		void removeFromWorkAndDestroy(SlabBlock* slab) {
-			//remove from work
-			if (slab != this->work) {
-				slab->prev->next = slab->next;
-				slab->next->prev = slab->prev;
-			}
-			else {
-				//remove head from work
-				if (slab->next != slab) {
-					slab->prev->next = slab->next;
-					slab->next->prev = slab->prev;
-					this->work = slab->next;
-				}
-				else {
-					this->work = nullptr;
-				}
-			}
+			list::unlink(this->work, slab);
 
+#if SLAB_ENABLE_GENERATIONS
+			// all generations are even here, the next slab starts past the newest one so old handles stay stale
+			this->slab_table.tag(slab->slot).generation = *std::max_element(std::begin(slab->generations), std::end(slab->generations));
+#endif
+#if SLAB_ENABLE_PTR_TAG
+			this->slab_table.tag(slab->slot).tag = *std::max_element(std::begin(slab->tags), std::end(slab->tags));
+#endif
+#if SLAB_ENABLE_HANDLES
+			this->slab_table.release(slab->slot); // never allocates, so deallocate cannot throw
+#endif
 			SlabBlock::destroy(slab);
+			SLAB_STAT(++this->counters.slab_destroys);
+			SLAB_PROBE3(slab_destroy, this, slab, this->total_count - 1);
+			this->churn_destroyed = ++this->churn_clock;
+			SLAB_STAT(--this->occupancy[0]);
 			assert(this->total_count > 0 && "Invalid total count.");
 			--this->total_count;
 			assert(this->reserved_count > 0 && "Invalid reserved count.");
 			--this->reserved_count;
 		}
+
+		// ctz walk over the allocated units of one slab
+		template<typename Fn>
+		void visitSlab(SlabBlock* slab, Fn& fn) const {
+			uint64_t live = ~slab->bitMap SLAB_QUARANTINE(& ~slab->quarantineMap);
+
+			while (live != 0) {
+				const uint32_t index = bits::ctz64(live);
+				live &= live - 1;
+				fn(static_cast<void*>(slab->getUnitByIndex(this->unitMetaSize, index)->payload));
+			}
+		}
+
+		// visitSlab over slabs[0, count), prefetching the next header
+		template<typename Fn>
+		void visitSlabs(SlabBlock* const* slabs, const size_t count, Fn& fn) const {
+			for (size_t i = 0; i < count; ++i) {
+				if (i + 1 < count) SLAB_PREFETCH(slabs[i + 1]);
+				this->visitSlab(slabs[i], fn);
+			}
+		}
+
+		// every slab, full list first, in the order visit_units walks them
+		void collectSlabs(std::vector<SlabBlock*>& slabs) const {
+			slabs.reserve(slabs.size() + this->total_count);
+			for (SlabBlock* begin : { this->full, this->work }) {
+				if (begin == nullptr) continue;
+
+				SlabBlock* slab = begin;
+				do {
+					slabs.push_back(slab);
+					slab = slab->next;
+				} while (slab != begin);
+			}
+		}
+
+#if SLAB_ENABLE_HANDLES
+		void invalidHandle(const UnitHandle handle) {
+			std::cerr << "deallocate: Invalid or freed handle " << handle << "." << std::endl;
+			SLAB_STAT(++this->counters.invalid_frees);
+			SLAB_PROBE2(invalid_free, this, static_cast<void*>(nullptr));
+		}
+#endif
 	public:
 		SlabAllocator(const SlabAllocator&) = delete;
 		SlabAllocator& operator=(const SlabAllocator&) = delete;
@@ -278,7 +955,10 @@ namespace slab {
 			}
 
 			unitSize = (unitSize + 7) & ~7;// align to 8
-			this->unitMetaSize = (sizeof(SlabUnit) + unitSize);
+#if SLAB_ENABLE_RANDOM_UNIT
+			this->random_state = randomSeed(this);
+#endif
+			this->unitMetaSize = (sizeof(SlabUnit) + unitSize + unit_guard_size);
 
 			//create node
 			SlabBlock* slab = this->makeBlock();
@@ -287,9 +967,15 @@ namespace slab {
 			this->total_count = 1;
 			this->reserved_count = 1;
 			this->reserved_limit = std::max(reserved_limit, 1u);// ensure that there is at least one free
+			SLAB_STAT(this->statSlabCount());
+			SLAB_QUARANTINE(this->set_quarantine(SLAB_QUARANTINE_BYTES));
 		}
 
 		~SlabAllocator() {
+			SLAB_QUARANTINE(this->set_quarantine(0));
+			SLAB_LEAK(this->leakReport());
+			this->unregister();
+
 			if (this->full != nullptr) {
 				destroyList(this->full);
 				this->full = nullptr;
@@ -310,48 +996,213 @@ namespace slab {
 		}
 
 		uint32_t unitSize() const {
-			return this->unitMetaSize - sizeof(SlabUnit);
+			return this->unitMetaSize - sizeof(SlabUnit) - unit_guard_size;
+		}
+
+		/**
+		 * @brief effective reserved free slab limit: reserved_limit plus the current churn boost
+		 */
+		uint32_t reserve_limit() const {
+			return this->reserved_limit + this->reserved_boost;
+		}
+
+		/**
+		 * @brief let churn detection raise the reserve above reserved_limit (off by default)
+		 */
+		void set_adaptive_reserve(const bool enable) {
+			this->adaptive_reserve = enable;
+			if (!enable) {
+				this->reserved_boost = 0;
+				this->trimReserve();
+			}
+		}
+
+#if SLAB_ENABLE_QUARANTINE
+		/**
+		 * @brief change the quarantine budget; parked units are released first, 0 turns it off
+		 * @note the budget caps both the parked units (payload plus metadata) and the slabs they pin, whichever
+		 * is reached first: memory held back is at most max(bytes, one slab), plus 8 ring bytes per unit
+		 */
+		void set_quarantine(const size_t bytes) {
+			this->quarantineDrain();
+			_free(this->quarantine_ring);
+			this->quarantine_ring = nullptr;
+			this->quarantine_capacity = static_cast<uint32_t>(std::min<size_t>(bytes / this->unitMetaSize, UINT32_MAX));
+			this->quarantine_slab_limit = static_cast<uint32_t>(std::min<size_t>(std::max<size_t>(bytes / SlabBlock::byteSize(this->unitMetaSize), 1), UINT32_MAX));
+
+			if (this->quarantine_capacity != 0) {
+				this->quarantine_ring = (SlabUnit**)_malloc(sizeof(SlabUnit*) * this->quarantine_capacity);
+				if (this->quarantine_ring == nullptr) {
+					std::cerr << "set_quarantine: memory allocation failed, quarantine disabled." << std::endl;
+					this->quarantine_capacity = 0;
+				}
+			}
 		}
 
-		void* allocate() {
+		size_t quarantined() const {
+			return this->quarantine_size;
+		}
+#endif
+
+#if SLAB_ENABLE_CYCLES
+		/**
+		 * @brief count and cycles per allocate/deallocate path, timer overhead already subtracted
+		 */
+		const cycles::CycleStats& cycle_stats() const {
+			return this->cycle_counters;
+		}
+#endif
+
+#if SLAB_ENABLE_PROFILE
+		/**
+		 * @brief sample on average one allocation per `bytes` allocated bytes, 0 turns sampling off
+		 */
+		void set_sampling_interval(const uint64_t bytes) {
+			this->profiler.set_interval(bytes);
+		}
+
+		/**
+		 * @brief write the live sampled allocations as folded stacks (flamegraph.pl / speedscope input)
+		 */
+		void write_heap_profile(std::ostream& os) const {
+			this->profiler.write_folded(os);
+		}
+#endif
+
+		/**
+		 * @brief publish this allocator to slab::report() under the given name
+		 * @return false if the registry is full
+		 */
+		bool register_as(const char* name) {
+			return this->registerEntry(name != nullptr ? name : "", 0);
+		}
+
+		void unregister() {
+			if (this->registry_index >= 0) {
+				detail::registry_remove(this->registry_index);
+				this->registry_index = -1;
+			}
+		}
+
+		static constexpr bool stats_enabled = SLAB_ENABLE_STATS != 0;
+
+		/**
+		 * @brief copy of the counters, all zero when SLAB_ENABLE_STATS is off
+		 */
+		SlabStats stats() const {
+#if SLAB_ENABLE_STATS
+			return this->counters;
+#else
+			return SlabStats{};
+#endif
+		}
+
+		SLAB_SITE_NOINLINE void* allocate() {
+			SLAB_LEAK(void* const site = SLAB_CALL_SITE());
+			SLAB_CYCLES(cycles::Scope cycleScope(this->cycle_counters, cycles::alloc_fast));
+			this->churnTick();
 			SlabBlock* slab = this->work;
+			SLAB_STAT(this->statAllocate());
 
 			if (slab == nullptr) {
+				SLAB_CYCLES(cycleScope.set(cycles::alloc_create));
 				slab = this->makeBlock();
+				this->churnCreate();
 
 				this->work = slab;
 				// set the work slab to the new slab
 				++this->total_count;
+				SLAB_STAT(this->statSlabCount());
 				// no need to modify reserved_count
-				return slab->allocateUnit(this->unitMetaSize)->payload;
+				void* mem = slab->allocateUnit(this->unitMetaSize, this->unitRandom())->payload;
+				SLAB_GUARD(this->guardAllocate(SlabUnit::getUnitFromPayload(mem)));
+				SLAB_STAT(this->statOccupancy(slab, 1));
+				SLAB_PROFILE(this->profileAllocate(slab, mem));
+				SLAB_LEAK(leakRecord(slab, mem, site));
+				return tagUnit(slab, mem);
 			}
 
 			if (slab->isEmpty()) {
 				assert(this->reserved_count > 0 && "Invalid reserved count.");
 				--this->reserved_count;
+				if (this->reserved_count < this->reserved_boost) {
+					// more than reserved_limit empty slabs were drained: without the boost this one would be a create
+					this->churn_idle = churn_decay;
+				}
 			}
 
-			void* mem = slab->allocateUnit(this->unitMetaSize)->payload;
+			void* mem = slab->allocateUnit(this->unitMetaSize, this->unitRandom())->payload;
+			SLAB_GUARD(this->guardAllocate(SlabUnit::getUnitFromPayload(mem)));
+			SLAB_STAT(this->statOccupancy(slab, 1));
+			SLAB_PROFILE(this->profileAllocate(slab, mem));
+			SLAB_LEAK(leakRecord(slab, mem, site));
 
 			// move to full
 			if (slab->isFull()) {
+				SLAB_CYCLES(cycleScope.set(cycles::alloc_to_full));
 				this->moveFromWorkToFull(slab);
 			}
 
-			return mem;
+			return tagUnit(slab, mem);
 		}
 
 		void deallocate(void* ptr) {
+			this->deallocateWith(ptr, [](void*) {});
+		}
+
+	protected:
+		/**
+		 * @brief deallocate, calling destroy(payload) once the pointer is known to name a live unit
+		 * @note stale, foreign and double frees are rejected before destroy runs, so it never touches another object
+		 */
+		template<typename Destroy>
+		void deallocateWith(void* ptr, Destroy&& destroy) {
+			SLAB_CYCLES(cycles::Scope cycleScope(this->cycle_counters, cycles::free_error));
+
 			if (ptr == nullptr) {
 				std::cerr << "deallocate: Invalid pointer nullptr." << std::endl;
+				SLAB_STAT(++this->counters.invalid_frees);
+				SLAB_PROBE2(invalid_free, this, ptr);
 				return;
 			}
 
+			this->churnTick();
+
+#if SLAB_ENABLE_PTR_TAG
+			const uint8_t tag = pointer_tag(ptr);
+			ptr = untag(ptr);
+#endif
+
+#if SLAB_ENABLE_PTR_TAG
+			// payloads are 8-aligned, anything else is interior and has no header to read
+			if ((reinterpret_cast<uintptr_t>(ptr) & 7) != 0) {
+				std::cerr << "deallocate: Interior pointer (misaligned)." << std::endl;
+				SLAB_STAT(++this->counters.invalid_frees);
+				SLAB_PROBE2(invalid_free, this, ptr);
+				return;
+			}
+#endif
+
 			//getSlabUnitFromPtr
 			SlabUnit* unit = SlabUnit::getUnitFromPayload(ptr);
 
+#if SLAB_ENABLE_PTR_TAG
+			// in front of an interior pointer lies user data, so the header only names a table slot: the slab comes
+			// from the table, and nothing in it is read before the pointer is shown to be exactly one of its units
+			SlabBlock* slab = this->slab_table.find(unit->slot);
+
+			// interior and foreign pointers fail the first two tests, stale pointers to a reused unit the third
+			if (slab == nullptr || slab->getUnitByIndex(this->unitMetaSize, unit->index) != unit || slab->tags[unit->index] != tag) {
+				std::cerr << "deallocate: Stale, interior or foreign pointer (tag " << static_cast<uint32_t>(tag) << ")." << std::endl;
+				SLAB_STAT(++this->counters.invalid_frees);
+				SLAB_PROBE2(invalid_free, this, ptr);
+				return;
+			}
+#else
 			if (unit->index >= 64) {
 				std::cerr << "deallocate: Invalid unit index " << unit->index << std::endl;
+				SLAB_STAT(++this->counters.invalid_frees);
+				SLAB_PROBE2(invalid_free, this, ptr);
 				return;
 			}
 
@@ -360,66 +1211,304 @@ namespace slab {
 
 			if (slab->allocator != this) {
 				std::cerr << "deallocate: Invalid slab allocator." << std::endl;
+				SLAB_STAT(++this->counters.invalid_frees);
+				SLAB_PROBE2(invalid_free, this, ptr);
 				return; // invalid slab
 			}
+#endif
 
-			if (slab->isUnitAllocated(unit->index)) {
-				bool isFull = slab->isFull();
-				slab->deallocateUnit(unit->index);
-
-				if (isFull) {
-					this->moveFromFullToWork(slab);
+			if (slab->isUnitAllocated(unit->index) SLAB_QUARANTINE(&& !bits::get(slab->quarantineMap, unit->index))) {
+				destroy(static_cast<void*>(unit->payload));
+				SLAB_CYCLES(cycleScope.set(cycles::free_fast));
+#if SLAB_ENABLE_GENERATIONS
+				++slab->generations[unit->index]; // even from here on, quarantined or not
+#endif
+				SLAB_GUARD(this->guardCheckCanary(unit));
+				SLAB_GUARD(this->guardFree(unit));
+				SLAB_STAT(this->statDeallocate());
+				SLAB_PROFILE(this->profileDeallocate(slab, unit));
+
+#if SLAB_ENABLE_QUARANTINE
+				if (this->quarantine_capacity != 0) {
+					// park the unit, the oldest parked ones go back to their slabs in its place
+					this->quarantinePush(slab, unit);
 					return;
 				}
+#endif
 
-				if (slab->isEmpty()) {
-					// it's free now
-					++this->reserved_count;
-					if (this->reserved_count > this->reserved_limit) {
-						this->removeFromWorkAndDestroy(slab);
-					}
-				}
+				const Release release = this->releaseUnit(slab, unit);
+				SLAB_CYCLES(cycleScope.set(release == Release::to_work ? cycles::free_to_work : release == Release::destroy ? cycles::free_destroy : cycles::free_fast));
+				(void)release;
 			}
 			else {
 				std::cerr << "deallocate: Unit is already freed in bitMap." << std::endl;
+				SLAB_STAT(++this->counters.double_frees);
+				SLAB_PROBE2(double_free, this, ptr);
 			}
 		}
 
-		void print_stats() {
-			std::cout << "print_stats:" << std::endl;
+	public:
+#if SLAB_ENABLE_HANDLES
+		/**
+		 * @brief free the unit a handle names, reported like an invalid pointer if it is not live
+		 */
+		void deallocate(const UnitHandle handle) {
+			void* ptr = this->pointer_of(handle);
+			if (ptr == nullptr) {
+				this->invalidHandle(handle);
+				return;
+			}
 
-			if (this->full != nullptr) {
-				uint32_t count = 0;
-				SlabBlock* slab = this->full;
+			this->deallocate(ptr);
+		}
+
+		/**
+		 * @brief handle of a pointer returned by allocate
+		 */
+		UnitHandle handle_of(const void* ptr) const {
+			const SlabUnit* unit = SlabUnit::getUnitFromPayload(untag(ptr));
+			return (SlabBlock::getBlockFromUnit(unit)->slot << 6) | unit->index;
+		}
+
+		/**
+		 * @brief payload of a live handle, unchecked: one table load and a multiply-add
+		 * @note the pointer carries no tag, it is for dereferencing only
+		 */
+		void* resolve(const UnitHandle handle) const {
+			return this->slab_table[handle >> 6]->getUnitByIndex(this->unitMetaSize, handle & 63)->payload;
+		}
+
+		/**
+		 * @brief the pointer allocate returned for a live handle, nullptr if the handle names no live unit
+		 */
+		void* pointer_of(const UnitHandle handle) const {
+			const SlabBlock* slab = handle != invalid_handle ? this->slab_table.find(handle >> 6) : nullptr;
+			const uint32_t index = handle & 63;
+			if (slab == nullptr || !slab->isUnitAllocated(index)) return nullptr;
+#if SLAB_ENABLE_QUARANTINE
+			if (bits::get(slab->quarantineMap, index) != 0) return nullptr;
+#endif
+			return withTag(slab, slab->getUnitByIndex(this->unitMetaSize, index)->payload);
+		}
+#endif
+
+#if SLAB_ENABLE_GENERATIONS
+		/**
+		 * @brief generational handle of a pointer returned by allocate
+		 */
+		Handle checked_handle_of(const void* ptr) const {
+			const SlabUnit* unit = SlabUnit::getUnitFromPayload(untag(ptr));
+			const SlabBlock* slab = SlabBlock::getBlockFromUnit(unit);
+			return { (slab->slot << 6) | unit->index, slab->generations[unit->index] };
+		}
+
+		/**
+		 * @brief payload of the handle's unit, nullptr once that unit was freed (or the handle is invalid)
+		 * @note the pointer carries no tag, it is for dereferencing only
+		 */
+		void* get(const Handle handle) const {
+			const SlabBlock* slab = this->slab_table.find(handle.index >> 6);
+
+			// a destroyed slab's slot is nullptr, a reused one starts past every generation issued before
+			if (slab == nullptr || slab->generations[handle.index & 63] != handle.generation) return nullptr;
+			return slab->getUnitByIndex(this->unitMetaSize, handle.index & 63)->payload;
+		}
+
+		void deallocate(const Handle handle) {
+			void* mem = this->get(handle);
+			if (mem == nullptr) {
+				this->invalidHandle(handle.index);
+				return;
+			}
+
+			this->deallocate(withTag(SlabBlock::getBlockFromUnit(SlabUnit::getUnitFromPayload(mem)), mem));
+		}
+#endif
+
+		/**
+		 * @brief occupancy and footprint summary
+		 * @note O(1) with SLAB_ENABLE_STATS, otherwise walks the work list once (the full list is never walked)
+		 */
+		SlabSnapshot snapshot() const {
+			SlabSnapshot snap;
+			snap.unit_size = this->unitSize();
+			snap.slab_bytes = SlabBlock::byteSize(this->unitMetaSize);
+			snap.total_slabs = this->total_count;
+			snap.full_slabs = this->full_count;
+			snap.work_slabs = this->total_count - this->full_count;
+			snap.empty_slabs = this->reserved_count;
+
+#if SLAB_ENABLE_STATS
+			std::copy(this->occupancy, this->occupancy + 65, snap.occupancy);
+#else
+			snap.occupancy[64] = this->full_count;
+
+			if (this->work != nullptr) {
+				const SlabBlock* slab = this->work;
 
 				do {
+					++snap.occupancy[64 - bits::popcnt64(slab->bitMap)];
 					slab = slab->next;
-					++count;
-				} while (slab != this->full);
+				} while (slab != this->work);
+			}
+#endif
 
-				std::cout << "full count: " << count << std::endl << std::endl;
+			for (uint32_t i = 1; i <= 64; ++i) {
+				snap.live_units += static_cast<uint64_t>(i) * snap.occupancy[i];
 			}
 
-			if (this->work != nullptr) {
-				uint32_t id = 1;
-				SlabBlock* slab = this->work;
+			snap.bytes_in_use = snap.live_units * snap.unit_size;
+			snap.bytes_reserved = static_cast<uint64_t>(snap.total_slabs) * snap.slab_bytes;
+			return snap;
+		}
+
+		/**
+		 * @brief call fn(slab address, live units) for every slab, full list first
+		 */
+		template<typename Fn>
+		void visit_slabs(Fn&& fn) const {
+			for (const SlabBlock* begin : { this->full, this->work }) {
+				if (begin == nullptr) continue;
 
+				const SlabBlock* slab = begin;
 				do {
-					std::cout << "slab_" << id << " " << 64 - bits::popcnt64(slab->bitMap) << " / 64" << std::endl;
-					SlabBlock::print_bitMap(slab->bitMap);
-					std::cout << std::endl;
+					fn(static_cast<const void*>(slab), static_cast<uint32_t>(64 - bits::popcnt64(slab->bitMap)));
 					slab = slab->next;
+				} while (slab != begin);
+			}
+		}
 
-					++id;
-				} while (slab != this->work);
+		/**
+		 * @brief call fn(payload) for every allocated unit, quarantined units excluded
+		 * @note fn must not allocate from or free to this allocator while the walk runs
+		 */
+		template<typename Fn>
+		void visit_units(Fn&& fn) const {
+			for (SlabBlock* begin : { this->full, this->work }) {
+				if (begin == nullptr) continue;
+
+				SlabBlock* slab = begin;
+				do {
+					SlabBlock* next = slab->next;
+					SLAB_PREFETCH(next); // its bitMap is the first thing the next round reads
+					this->visitSlab(slab, fn);
+					slab = next;
+				} while (slab != begin);
+			}
+		}
+
+		/**
+		 * @brief write the snapshot as one line of JSON
+		 */
+		void print_stats(std::ostream& os = std::cout) const {
+			this->snapshot().write_json(os);
+			os << std::endl;
+		}
+	};
+
+	/**
+	 * @brief write every registered allocator and the totals as one line of JSON to fd
+	 * @note reads counters only (slab lists are never walked) and only calls write(2), so it may run
+	 * in a signal handler or on a diagnostics thread; numbers are approximate while owners keep working
+	 */
+	inline void report(const int fd) {
+		detail::registry_readers.fetch_add(1, std::memory_order_seq_cst);
+
+		detail::ReportWriter out(fd);
+		uint64_t count = 0, slabs = 0, bytes_reserved = 0;
+#if SLAB_ENABLE_STATS
+		uint64_t bytes_in_use = 0;
+#endif
+
+		out.put("{\"allocators\":[");
+		for (int32_t i = 0; i < registry_capacity; ++i) {
+			const SlabAllocator* allocator = detail::registry[i].allocator.load(std::memory_order_acquire);
+			if (allocator == nullptr) continue;
+
+			const uint64_t unit_size = allocator->unitSize();
+			const uint64_t slab_bytes = SlabAllocator::SlabBlock::byteSize(allocator->unitMetaSize);
+			const uint64_t total = allocator->total_count;
+
+			if (count++ != 0) out.put(',');
+			out.put("{\"name\":");
+			out.putString(detail::registry[i].name);
+			out.putField("unit_size", unit_size);
+			if (detail::registry[i].object_size != 0) {
+				// what T loses per unit to 8-byte rounding, the SlabUnit header and the guard canary (guard_size)
+				out.putField("object_size", detail::registry[i].object_size);
+				out.putField("unit_overhead", allocator->unitMetaSize - detail::registry[i].object_size);
+				out.putField("guard_size", SlabAllocator::unit_guard_size);
 			}
+			out.putField("slabs", total);
+			out.putField("full", allocator->full_count);
+			out.putField("empty", allocator->reserved_count);
+			out.putField("bytes_reserved", total * slab_bytes);
+
+			slabs += total;
+			bytes_reserved += total * slab_bytes;
+
+#if SLAB_ENABLE_STATS
+			const SlabStats st = allocator->counters;
+			out.putField("live_units", st.live_units);
+			out.putField("bytes_in_use", st.live_units * unit_size);
+			out.putField("allocations", st.allocations);
+			out.putField("deallocations", st.deallocations);
+			out.putField("peak_live_units", st.peak_live_units);
+			out.putField("peak_slabs", st.peak_slabs);
+			out.putField("double_frees", st.double_frees);
+			out.putField("invalid_frees", st.invalid_frees);
+
+			bytes_in_use += st.live_units * unit_size;
+#endif
+			out.put('}');
+		}
 
-			std::cout << "End" << std::endl;
+		out.put("],\"total\":{");
+		out.putField("allocators", count, true);
+		out.putField("slabs", slabs);
+		out.putField("bytes_reserved", bytes_reserved);
+#if SLAB_ENABLE_STATS
+		out.putField("bytes_in_use", bytes_in_use);
+#endif
+		out.put("}}\n");
+		out.flush();
+
+		detail::registry_readers.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	struct PoolInfo {
+		std::string_view type_name;
+		uint32_t object_size = 0;		// sizeof(T)
+		uint32_t unit_size = 0;			// sizeof(T) rounded up to 8
+		uint32_t unit_meta_size = 0;	// unit_size plus the SlabUnit header plus guard_size
+		uint32_t guard_size = 0;		// canary bytes per unit, 8 with SLAB_ENABLE_GUARD, else 0
+		uint64_t live_units = 0;
+		uint64_t peak_live_units = 0;	// 0 unless SLAB_ENABLE_STATS
+		uint64_t wasted_bytes = 0;		// live_units * (unit_meta_size - object_size)
+
+		void write_json(std::ostream& os) const {
+			os << "{\"type\":\"";
+			for (const char c : this->type_name) {
+				os << ((c == '"' || c == '\\') ? '?' : c);
+			}
+			os << "\",\"object_size\":" << this->object_size
+				<< ",\"unit_size\":" << this->unit_size
+				<< ",\"unit_meta_size\":" << this->unit_meta_size
+				<< ",\"guard_size\":" << this->guard_size
+				<< ",\"live_units\":" << this->live_units
+				<< ",\"peak_live_units\":" << this->peak_live_units
+				<< ",\"wasted_bytes\":" << this->wasted_bytes << "}";
 		}
 	};
 
+	namespace detail {
+		template<typename T>
+		struct ParallelWalk;	// parallel.hpp
+	}
+
 	template<typename T>
 	class ObjectPool : protected SlabAllocator {
+		friend struct detail::ParallelWalk<T>;
 	protected:
 		void destroyList(SlabBlock* begin) {
 			SlabBlock* slab = begin;
@@ -446,7 +1535,68 @@ namespace slab {
 		ObjectPool& operator=(ObjectPool&&) = delete;
 
 		ObjectPool(uint32_t reserved_limit = 4) : SlabAllocator(sizeof(T), reserved_limit) {}
+
+		using SlabAllocator::reserve_limit;
+		using SlabAllocator::set_adaptive_reserve;
+		/**
+		 * @brief register under the name of T, reports then show sizeof(T) against the unit size
+		 */
+		bool register_as() {
+			return this->registerEntry(slab::type_name<T>(), sizeof(T));
+		}
+
+		bool register_as(const char* name) {
+			return this->registerEntry(name != nullptr ? name : "", sizeof(T));
+		}
+
+		/**
+		 * @brief type name, padding and live/peak counts of this pool
+		 * @note live_units costs a work list walk unless SLAB_ENABLE_STATS
+		 */
+		PoolInfo info() const {
+			PoolInfo info;
+			info.type_name = slab::type_name<T>();
+			info.object_size = sizeof(T);
+			info.unit_size = this->unitSize();
+			info.unit_meta_size = this->unitMetaSize;
+			info.guard_size = unit_guard_size;
+			info.live_units = this->snapshot().live_units;
+			info.peak_live_units = this->stats().peak_live_units;
+			info.wasted_bytes = info.live_units * (info.unit_meta_size - info.object_size);
+			return info;
+		}
+		using SlabAllocator::unregister;
+#if SLAB_ENABLE_PROFILE
+		using SlabAllocator::set_sampling_interval;
+		using SlabAllocator::write_heap_profile;
+#endif
+#if SLAB_ENABLE_CYCLES
+		using SlabAllocator::cycle_stats;
+#endif
+#if SLAB_ENABLE_QUARANTINE
+		using SlabAllocator::set_quarantine;
+		using SlabAllocator::quarantined;
+#endif
+		using SlabAllocator::stats_enabled;
+		using SlabAllocator::stats;
+		using SlabAllocator::unitSize;
+		using SlabAllocator::snapshot;
+		using SlabAllocator::visit_slabs;
+		using SlabAllocator::visit_units;
+#if SLAB_ENABLE_HANDLES
+		using SlabAllocator::handle_of;
+#endif
+#if SLAB_ENABLE_GENERATIONS
+		using SlabAllocator::checked_handle_of;
+#endif
+		using SlabAllocator::print_stats;
+
 		~ObjectPool() {
+			// parked objects are already destructed, they must not reach destroyList
+			SLAB_QUARANTINE(this->set_quarantine(0));
+			SLAB_LEAK(this->leakReport());
+			this->unregister();
+
 			if (this->full != nullptr) {
 				destroyList(this->full);
 				this->full = nullptr;
@@ -457,18 +1607,88 @@ namespace slab {
 			}
 		}
 
+		/**
+		 * @brief call fn(T&) for every live object
+		 * @note fn must not allocate from or deallocate to this pool
+		 */
+		template<typename Fn>
+		void for_each(Fn&& fn) {
+			this->visit_units([&fn](void* payload) {
+				fn(*reinterpret_cast<T*>(payload));
+			});
+		}
+
 		template<typename... Args>
-		T* allocate(Args&&... args) {
-			return new (SlabAllocator::allocate()) T(std::forward<Args>(args)...);// allocate memory for T using SlabAllocator
+		SLAB_SITE_INLINE T* allocate(Args&&... args) {
+			T* ptr = reinterpret_cast<T*>(SlabAllocator::allocate());// allocate memory for T using SlabAllocator
+			new (slab::untag(ptr)) T(std::forward<Args>(args)...);
+			return ptr;
 		}
 
 		void deallocate(T* ptr) {
-			ptr->~T(); // call destructor
-			SlabAllocator::deallocate(ptr);
+			// the destructor only runs once the pointer is checked, a stale one must not destroy the unit's new object
+			this->deallocateWith(ptr, [](void* mem) {
+				static_cast<T*>(mem)->~T();
+			});
 		}
 
+#if SLAB_ENABLE_HANDLES
+		/**
+		 * @brief allocate and name the object by a 32-bit handle instead of a pointer
+		 */
+		template<typename... Args>
+		SLAB_SITE_INLINE UnitHandle allocate_handle(Args&&... args) {
+			return this->handle_of(this->allocate(std::forward<Args>(args)...));
+		}
+
+		/**
+		 * @brief object of a live handle, unchecked
+		 */
+		T* resolve(const UnitHandle handle) const {
+			return reinterpret_cast<T*>(SlabAllocator::resolve(handle));
+		}
+
+		void deallocate(const UnitHandle handle) {
+			T* ptr = reinterpret_cast<T*>(this->pointer_of(handle));
+			if (ptr == nullptr) {
+				this->invalidHandle(handle);
+				return;
+			}
+
+			this->deallocate(ptr);
+		}
+#endif
+
+#if SLAB_ENABLE_GENERATIONS
+		/**
+		 * @brief allocate and name the object by a generational handle
+		 */
+		template<typename... Args>
+		SLAB_SITE_INLINE Handle allocate_checked(Args&&... args) {
+			return this->checked_handle_of(this->allocate(std::forward<Args>(args)...));
+		}
+
+		/**
+		 * @brief object of a handle, nullptr when the handle is stale
+		 */
+		T* get(const Handle handle) const {
+			return reinterpret_cast<T*>(SlabAllocator::get(handle));
+		}
+
+		void deallocate(const Handle handle) {
+			T* mem = this->get(handle);
+			if (mem == nullptr) {
+				this->invalidHandle(handle.index);
+				return;
+			}
+
+			mem->~T();
+			SlabAllocator::deallocate(handle);
+		}
+#endif
+
 		// for advanced users who want to manage construction and destruction themselves
-		T* allocate_no_construct() {
+		SLAB_SITE_INLINE T* allocate_no_construct() {
 			return reinterpret_cast<T*>(SlabAllocator::allocate());
 		}
 
@@ -478,4 +1698,18 @@ namespace slab {
 		}
 	};
 #undef OFFSET_OF
+#undef SLAB_STAT
+#undef SLAB_PROFILE
+#undef SLAB_LEAK
+#undef SLAB_CYCLES
+#undef SLAB_GUARD
+#undef SLAB_QUARANTINE
+#undef SLAB_ASAN_POISON
+#undef SLAB_ASAN_UNPOISON
+#undef SLAB_PROBE2
+#undef SLAB_PROBE3
+#undef SLAB_CALL_SITE
+#undef SLAB_SITE_NOINLINE
+#undef SLAB_SITE_INLINE
+#undef SLAB_PREFETCH
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "./slab.hpp"
+
+namespace slab {
+	/**
+	 * @brief hands a slice's unit back to its pool once the last view is gone, on the thread that dropped it
+	 * @param context what was passed to BasicSlice::allocate with the recycler
+	 * @param unit what the pool's allocate returned, tag included
+	 */
+	using SliceRecycler = void (*)(void* context, void* unit);
+
+	namespace detail {
+		/**
+		 * @brief front of a unit that backs slices, the bytes follow it
+		 */
+		template<bool Atomic>
+		struct alignas(8) SliceBlock {
+			std::conditional_t<Atomic, std::atomic<uint32_t>, uint32_t> refs;
+			uint32_t capacity;			// bytes after the header
+			void* unit;					// what allocate returned, tag included, handed back to recycle
+			SliceRecycler recycle;
+			void* context;				// the owning SlabAllocator unless a recycler was given
+
+			char* bytes() {
+				return reinterpret_cast<char*>(this) + sizeof(SliceBlock);
+			}
+
+			void retain() {
+				if constexpr (Atomic) {
+					this->refs.fetch_add(1, std::memory_order_relaxed);
+				}
+				else {
+					++this->refs;
+				}
+			}
+
+			void release() {
+				if constexpr (Atomic) {
+					// release publishes this owner's writes, acquire on the last drop sees everyone's
+					if (this->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+				}
+				else {
+					if (--this->refs != 0) return;
+				}
+
+				this->recycle(this->context, this->unit);
+			}
+
+			uint32_t count() const {
+				if constexpr (Atomic) {
+					return this->refs.load(std::memory_order_relaxed);
+				}
+				else {
+					return this->refs;
+				}
+			}
+		};
+	}
+
+	/**
+	 * @brief refcounted view of bytes in a pool unit, the unit goes back to its SlabAllocator with the last view
+	 * @tparam Atomic true for slices shared across threads, false for single-threaded parsers
+	 * @note the last view frees on whatever thread drops it. SlabAllocator is not thread-safe, so slices that
+	 * outlive their thread need a recycler that locks the pool or queues the unit for the pool's thread.
+	 */
+	template<bool Atomic>
+	class BasicSlice {
+	protected:
+		using Block = detail::SliceBlock<Atomic>;
+
+		Block* block = nullptr;
+		uint32_t offset = 0;
+		uint32_t length = 0;
+
+		BasicSlice(Block* block, const uint32_t offset, const uint32_t length) : block(block), offset(offset), length(length) {}
+
+	public:
+		// bytes of every unit the slice header takes
+		static constexpr uint32_t header_size = sizeof(Block);
+
+		BasicSlice() = default;
+
+		BasicSlice(const BasicSlice& other) : block(other.block), offset(other.offset), length(other.length) {
+			if (this->block != nullptr) this->block->retain();
+		}
+
+		BasicSlice(BasicSlice&& other) noexcept : block(other.block), offset(other.offset), length(other.length) {
+			other.block = nullptr;
+			other.offset = other.length = 0;
+		}
+
+		BasicSlice& operator=(BasicSlice other) noexcept {
+			this->swapWith(other);
+			return *this;
+		}
+
+		~BasicSlice() {
+			if (this->block != nullptr) this->block->release();
+		}
+
+		/**
+		 * @brief take one unit of pool and view all of it (unitSize() - header_size bytes)
+		 * @return an empty slice if the unit is too small for the header or the pool is out of memory
+		 * @note the last view calls pool.deallocate directly, only for slices that stay on the pool's thread
+		 */
+		static BasicSlice allocate(SlabAllocator& pool) {
+			return allocate(pool, [](void* context, void* unit) {
+				static_cast<SlabAllocator*>(context)->deallocate(unit);
+			}, &pool);
+		}
+
+		/**
+		 * @brief as above, but the last view calls recycle(context, unit) instead of pool.deallocate
+		 */
+		static BasicSlice allocate(SlabAllocator& pool, const SliceRecycler recycle, void* context) {
+			if (pool.unitSize() <= header_size) {
+				std::cerr << "BasicSlice: unit size " << pool.unitSize() << " leaves no room after the slice header." << std::endl;
+				return BasicSlice();
+			}
+
+			void* unit = pool.allocate();
+			if (unit == nullptr) return BasicSlice();
+
+			Block* block = new (slab::untag(unit)) Block();
+			block->refs = 1;
+			block->capacity = pool.unitSize() - header_size;
+			block->unit = unit;
+			block->recycle = recycle;
+			block->context = context;
+			return BasicSlice(block, 0, block->capacity);
+		}
+
+		/**
+		 * @brief a view of [from, from + count) of this one, sharing the unit; clamped to this slice
+		 */
+		BasicSlice subslice(uint32_t from, uint32_t count = UINT32_MAX) const {
+			if (this->block == nullptr) return BasicSlice();
+
+			from = from < this->length ? from : this->length;
+			count = count < this->length - from ? count : this->length - from;
+			this->block->retain();
+			return BasicSlice(this->block, this->offset + from, count);
+		}
+
+		/**
+		 * @brief cut off and return the first count bytes, this slice keeps the rest
+		 */
+		BasicSlice split_prefix(const uint32_t count) {
+			BasicSlice head = this->subslice(0, count);
+			this->remove_prefix(head.length);
+			return head;
+		}
+
+		void remove_prefix(uint32_t count) {
+			count = count < this->length ? count : this->length;
+			this->offset += count;
+			this->length -= count;
+		}
+
+		void remove_suffix(uint32_t count) {
+			this->length -= count < this->length ? count : this->length;
+		}
+
+		/**
+		 * @brief drop the reference now, the slice becomes empty
+		 */
+		void reset() {
+			BasicSlice().swapWith(*this);
+		}
+
+		char* data() const {
+			return this->block != nullptr ? this->block->bytes() + this->offset : nullptr;
+		}
+
+		uint32_t size() const {
+			return this->length;
+		}
+
+		bool empty() const {
+			return this->length == 0;
+		}
+
+		char& operator[](const uint32_t i) const {
+			return this->data()[i];
+		}
+
+		std::string_view view() const {
+			return std::string_view(this->data(), this->length);
+		}
+
+		/**
+		 * @brief views sharing the unit, 0 for an empty slice
+		 */
+		uint32_t use_count() const {
+			return this->block != nullptr ? this->block->count() : 0;
+		}
+
+	protected:
+		void swapWith(BasicSlice& other) {
+			std::swap(this->block, other.block);
+			std::swap(this->offset, other.offset);
+			std::swap(this->length, other.length);
+		}
+	};
+
+	using Slice = BasicSlice<true>;
+	using LocalSlice = BasicSlice<false>;
+}
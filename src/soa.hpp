@@ -0,0 +1,355 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "./slab.hpp"
+
+namespace slab {
+	/**
+	 * @brief 64 contiguous elements of one field, entry i is live when bit i of the chunk's live mask is set
+	 */
+	template<typename T>
+	struct Span {
+		T* data;
+		static constexpr size_t size = 64;
+
+		T& operator[](const size_t i) const {
+			return this->data[i];
+		}
+
+		T* begin() const {
+			return this->data;
+		}
+
+		T* end() const {
+			return this->data + size;
+		}
+	};
+
+	/**
+	 * @brief struct-of-arrays pool, every slab holds 64 entities as one array per field
+	 *
+	 * Slabs follow the SlabAllocator lifecycle (work/full lists, bitMap with 1 = free,
+	 * empty slabs kept up to reserved_limit) through the shared list and SlotTable helpers;
+	 * only the block layout is its own. Entities are addressed by a 32-bit handle,
+	 * (slab table index << 6) | unit index.
+	 */
+	template<typename... Fields>
+	class SoAPool {
+		static_assert(sizeof...(Fields) > 0, "SoAPool needs at least one field");
+
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle invalid_handle = UINT32_MAX;
+
+		template<size_t I>
+		using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+	protected:
+		static constexpr size_t field_count = sizeof...(Fields);
+		static constexpr size_t column_align = 64;	// a cache line, enough for any SIMD load
+
+		struct Block {
+			void* raw;				// what _malloc returned, the block itself is aligned up from it
+			Block* next;
+			Block* prev;
+			uint64_t bitMap;		// bit==1 means free
+			uint32_t slot;			// index in the slab table
+		};
+
+		static constexpr size_t alignUp(const size_t value, const size_t align) {
+			return (value + align - 1) / align * align;
+		}
+
+		// byte offset of column I from the block start
+		template<size_t I>
+		static constexpr size_t columnOffset() {
+			if constexpr (I == 0) {
+				return alignUp(sizeof(Block), column_align);
+			}
+			else {
+				return alignUp(columnOffset<I - 1>() + sizeof(field_type<I - 1>) * 64, column_align);
+			}
+		}
+
+		static constexpr size_t blockSize() {
+			return columnOffset<field_count - 1>() + sizeof(field_type<field_count - 1>) * 64;
+		}
+
+		static constexpr uint32_t table_limit = 1u << 26;	// slots a Handle can name
+
+		Block* work = nullptr;
+		Block* full = nullptr;
+		SlotTable<Block> table;				// handle >> 6 -> slab
+		uint32_t total_count = 0;
+		uint32_t reserved_count = 0;		// empty slab count
+		uint32_t reserved_limit;
+		size_t live_count = 0;
+
+		template<size_t I>
+		static field_type<I>* column(Block* slab) {
+			return std::launder(reinterpret_cast<field_type<I>*>(reinterpret_cast<char*>(slab) + columnOffset<I>()));
+		}
+
+		Block* makeBlock() {
+			void* raw = _malloc(blockSize() + column_align - 1);
+			if (raw == nullptr) {
+				std::cerr << "SoAPool: failed in allocating memory." << std::endl;
+				exit(1);
+			}
+
+			Block* slab = reinterpret_cast<Block*>(alignUp(reinterpret_cast<uintptr_t>(raw), column_align));
+			slab->raw = raw;
+			slab->next = slab;
+			slab->prev = slab;
+			slab->bitMap = ~static_cast<uint64_t>(0);
+
+			slab->slot = this->table.acquire(slab, table_limit);
+			if (slab->slot == SlotTable<Block>::none) {
+				std::cerr << "SoAPool: slab table is full or out of memory." << std::endl;
+				exit(1);
+			}
+
+			++this->total_count;
+			++this->reserved_count;
+			return slab;
+		}
+
+		void destroyBlock(Block* slab) {
+			this->table.release(slab->slot);
+			--this->total_count;
+			_free(slab->raw);
+		}
+
+		template<size_t... I>
+		static void destroyUnit(Block* slab, const uint32_t index, std::index_sequence<I...>) {
+			(std::destroy_at(&column<I>(slab)[index]), ...);
+		}
+
+		// fields I.. of one entity from args (a tuple of references, empty = value-initialize);
+		// if a constructor throws, the fields already built are destroyed again before it propagates
+		template<size_t I, typename Tuple>
+		static void constructUnit(Block* slab, const uint32_t index, Tuple& args) {
+			if constexpr (I < field_count) {
+				if constexpr (std::tuple_size_v<Tuple> == 0) {
+					new (&column<I>(slab)[index]) field_type<I>();
+				}
+				else {
+					new (&column<I>(slab)[index]) field_type<I>(std::forward<std::tuple_element_t<I, Tuple>>(std::get<I>(args)));
+				}
+
+				try {
+					constructUnit<I + 1>(slab, index, args);
+				}
+				catch (...) {
+					std::destroy_at(&column<I>(slab)[index]);
+					throw;
+				}
+			}
+		}
+
+		void destroyList(Block* begin) {
+			Block* slab = begin;
+
+			do {
+				Block* next = slab->next;
+				for (uint64_t live = ~slab->bitMap; live != 0; live &= live - 1) {
+					destroyUnit(slab, bits::ctz64(live), std::index_sequence_for<Fields...>{});
+				}
+				this->destroyBlock(slab);
+				slab = next;
+			} while (slab != begin);
+		}
+
+		// slab of a live handle, nullptr (with a message) otherwise
+		Block* resolve(const Handle handle, const char* caller) const {
+			Block* slab = handle != invalid_handle ? this->table.find(handle >> 6) : nullptr;
+
+			if (slab == nullptr || bits::get(slab->bitMap, static_cast<uint8_t>(handle & 63)) != 0) {
+				std::cerr << caller << ": Invalid or freed handle " << handle << "." << std::endl;
+				return nullptr;
+			}
+			return slab;
+		}
+
+	public:
+		/**
+		 * @brief the chunk of one slab handed to for_each_chunk
+		 */
+		struct Chunk {
+			Block* slab;
+			uint64_t live;	// bit==1 means entry i holds an entity
+			Handle base;	// handle of entry 0
+
+			template<size_t I>
+			Span<field_type<I>> column() const {
+				return { SoAPool::column<I>(this->slab) };
+			}
+		};
+
+		SoAPool(const SoAPool&) = delete;
+		SoAPool& operator=(const SoAPool&) = delete;
+
+		SoAPool(SoAPool&&) = delete;
+		SoAPool& operator=(SoAPool&&) = delete;
+
+		SoAPool(const uint32_t reserved_limit = 4) : reserved_limit(std::max(reserved_limit, 1u)) {
+			this->work = this->makeBlock();
+		}
+
+		~SoAPool() {
+			if (this->full != nullptr) {
+				destroyList(this->full);
+				this->full = nullptr;
+			}
+			if (this->work != nullptr) {
+				destroyList(this->work);
+				this->work = nullptr;
+			}
+		}
+
+		/**
+		 * @brief construct an entity, fields value-initialized or built from one argument each
+		 */
+		template<typename... Args>
+		Handle allocate(Args&&... args) {
+			static_assert(sizeof...(Args) == 0 || sizeof...(Args) == field_count, "pass one argument per field or none");
+
+			if (this->work == nullptr) {
+				this->work = this->makeBlock();
+			}
+
+			Block* slab = this->work;
+			const uint32_t index = bits::ctz64(slab->bitMap);
+
+			// the entity is built before its bit is taken, a throwing field constructor leaves the slot free
+			auto forwarded = std::forward_as_tuple(std::forward<Args>(args)...);
+			constructUnit<0>(slab, index, forwarded);
+
+			if (slab->bitMap == ~static_cast<uint64_t>(0)) {
+				--this->reserved_count;
+			}
+			bits::set_zero(slab->bitMap, static_cast<uint8_t>(index));
+			++this->live_count;
+
+			if (slab->bitMap == 0) {
+				list::unlink(this->work, slab);
+				list::push_front(this->full, slab);
+			}
+
+			return (slab->slot << 6) | index;
+		}
+
+		void deallocate(const Handle handle) {
+			Block* slab = this->resolve(handle, "SoAPool::deallocate");
+			if (slab == nullptr) return;
+
+			const uint32_t index = handle & 63;
+			destroyUnit(slab, index, std::index_sequence_for<Fields...>{});
+
+			const bool wasFull = slab->bitMap == 0;
+			bits::set_one(slab->bitMap, static_cast<uint8_t>(index));
+			--this->live_count;
+
+			if (wasFull) {
+				list::unlink(this->full, slab);
+				list::push_front(this->work, slab);
+			}
+
+			if (slab->bitMap == ~static_cast<uint64_t>(0)) {
+				if (++this->reserved_count > this->reserved_limit) {
+					list::unlink(this->work, slab);
+					this->destroyBlock(slab);
+					--this->reserved_count;
+				}
+			}
+		}
+
+		/**
+		 * @brief field I of a live entity, nullptr if the handle is invalid or freed
+		 */
+		template<size_t I>
+		field_type<I>* try_get(const Handle handle) {
+			Block* slab = handle != invalid_handle ? this->table.find(handle >> 6) : nullptr;
+			if (slab == nullptr || bits::get(slab->bitMap, static_cast<uint8_t>(handle & 63)) != 0) return nullptr;
+			return &column<I>(slab)[handle & 63];
+		}
+
+		template<size_t I>
+		const field_type<I>* try_get(const Handle handle) const {
+			return const_cast<SoAPool*>(this)->template try_get<I>(handle);
+		}
+
+		/**
+		 * @brief field I of a live entity, unchecked (one table load and an add)
+		 */
+		template<size_t I>
+		field_type<I>& get(const Handle handle) {
+			return column<I>(this->table[handle >> 6])[handle & 63];
+		}
+
+		template<size_t I>
+		const field_type<I>& get(const Handle handle) const {
+			return column<I>(this->table[handle >> 6])[handle & 63];
+		}
+
+		/**
+		 * @brief call fn(const Chunk&) once per slab that holds entities
+		 * @note fn must not allocate from or deallocate to this pool
+		 */
+		template<typename Fn>
+		void for_each_chunk(Fn&& fn) {
+			for (Block* begin : { this->full, this->work }) {
+				if (begin == nullptr) continue;
+
+				Block* slab = begin;
+				do {
+					Block* next = slab->next;
+					if (~slab->bitMap != 0) {
+						fn(Chunk{ slab, ~slab->bitMap, slab->slot << 6 });
+					}
+					slab = next;
+				} while (slab != begin);
+			}
+		}
+
+		/**
+		 * @brief call fn(field_type<I>&) for every live entity
+		 */
+		template<size_t I, typename Fn>
+		void for_each(Fn&& fn) {
+			this->for_each_chunk([&fn](const Chunk& chunk) {
+				const Span<field_type<I>> span = chunk.template column<I>();
+				for (uint64_t live = chunk.live; live != 0; live &= live - 1) {
+					fn(span[bits::ctz64(live)]);
+				}
+			});
+		}
+
+		size_t size() const {
+			return this->live_count;
+		}
+
+		uint32_t slabCount() const {
+			return this->total_count;
+		}
+
+		/**
+		 * @brief bytes of one slab, header and all columns
+		 */
+		static constexpr size_t slabSize() {
+			return blockSize();
+		}
+	};
+}
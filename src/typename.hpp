@@ -0,0 +1,48 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace slab {
+	namespace detail {
+		template<typename T>
+		constexpr std::string_view raw_type_name() {
+#if defined(__clang__) || defined(__GNUC__)
+			return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+			return __FUNCSIG__;
+#else
+			return "";
+#endif
+		}
+
+		// the signature of raw_type_name<int>() tells where the type sits in any other instantiation
+		constexpr std::string_view probe_name = raw_type_name<int>();
+		constexpr size_t probe_prefix = probe_name.find("int");
+		constexpr size_t probe_suffix = probe_prefix == std::string_view::npos ? 0 : probe_name.size() - probe_prefix - 3;
+
+		constexpr std::string_view strip_prefix(std::string_view name, std::string_view prefix) {
+			return name.substr(0, prefix.size()) == prefix ? name.substr(prefix.size()) : name;
+		}
+	}
+
+	/**
+	 * @brief compile-time name of T parsed from the compiler's function signature, "unknown" if unsupported
+	 */
+	template<typename T>
+	constexpr std::string_view type_name() {
+		if constexpr (detail::probe_prefix == std::string_view::npos) {
+			return "unknown";
+		}
+		else {
+			constexpr std::string_view raw = detail::raw_type_name<T>();
+			constexpr std::string_view name = raw.substr(detail::probe_prefix, raw.size() - detail::probe_prefix - detail::probe_suffix);
+			// MSVC spells out the class key
+			return detail::strip_prefix(detail::strip_prefix(detail::strip_prefix(name, "struct "), "class "), "union ");
+		}
+	}
+}
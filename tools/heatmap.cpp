@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 IMSDcrueoft (https://github.com/IMSDcrueoft)
+ * See LICENSE file in the root directory for full license text.
+*/
+// Renders a file written by slab::HeatmapRecorder as a binary PPM image.
+//
+//   heatmap <input> <output.ppm> [--id N] [--mode occupancy|address] [--scale S]
+//
+// occupancy: x = sample, y = live units per slab (0 at the bottom, 64 at the top),
+//            colour = number of slabs with that occupancy (log scale)
+// address:   x = sample, y = slab address rank, colour = live units of that slab
+//            (black where the slab does not exist at that time)
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+struct Record {
+	uint64_t micros;
+	uint32_t id;
+	uint32_t unitSize;
+	std::vector<std::pair<uint64_t, uint8_t>> slabs;	// address, live units
+};
+
+static bool readU32(std::istream& in, uint32_t& value) {
+	uint8_t bytes[4];
+	if (!in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+	value = 0;
+	for (int i = 3; i >= 0; --i) value = (value << 8) | bytes[i];
+	return true;
+}
+
+static bool readU64(std::istream& in, uint64_t& value) {
+	uint8_t bytes[8];
+	if (!in.read(reinterpret_cast<char*>(bytes), 8)) return false;
+	value = 0;
+	for (int i = 7; i >= 0; --i) value = (value << 8) | bytes[i];
+	return true;
+}
+
+static bool readVarint(std::istream& in, uint64_t& value) {
+	value = 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		const int c = in.get();
+		if (c == EOF) return false;
+		value |= static_cast<uint64_t>(c & 0x7f) << shift;
+		if ((c & 0x80) == 0) return true;
+	}
+	return false;
+}
+
+// dark blue -> red -> yellow
+static void heat(const double t, uint8_t rgb[3]) {
+	const double x = std::min(std::max(t, 0.0), 1.0);
+	rgb[0] = static_cast<uint8_t>(255.0 * std::min(1.0, 2.0 * x));
+	rgb[1] = static_cast<uint8_t>(255.0 * std::max(0.0, 2.0 * x - 1.0));
+	rgb[2] = static_cast<uint8_t>(96.0 * (1.0 - x));
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "usage: heatmap <input> <output.ppm> [--id N] [--mode occupancy|address] [--scale S]" << std::endl;
+		return 1;
+	}
+
+	bool filterId = false, addressMode = false;
+	uint32_t id = 0, scale = 4;
+
+	for (int i = 3; i + 1 < argc; i += 2) {
+		if (std::strcmp(argv[i], "--id") == 0) {
+			filterId = true;
+			id = static_cast<uint32_t>(std::stoul(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "--mode") == 0) {
+			addressMode = std::strcmp(argv[i + 1], "address") == 0;
+		}
+		else if (std::strcmp(argv[i], "--scale") == 0) {
+			scale = std::max(1u, static_cast<uint32_t>(std::stoul(argv[i + 1])));
+		}
+	}
+
+	std::ifstream in(argv[1], std::ios::binary);
+	char magic[8];
+	if (!in.read(magic, 8) || std::memcmp(magic, "SLABHM01", 8) != 0) {
+		std::cerr << "heatmap: " << argv[1] << " is not a slab heatmap file" << std::endl;
+		return 1;
+	}
+
+	std::vector<Record> records;
+	for (;;) {
+		Record record;
+		uint32_t count;
+		if (!readU64(in, record.micros) || !readU32(in, record.id) || !readU32(in, record.unitSize) || !readU32(in, count)) break;
+
+		uint64_t address = 0;
+		record.slabs.reserve(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			uint64_t delta;
+			const int live = (readVarint(in, delta) ? in.get() : EOF);
+			if (live == EOF) break;
+			address += delta << 3;
+			record.slabs.emplace_back(address, static_cast<uint8_t>(live));
+		}
+
+		if (!filterId || record.id == id) {
+			records.push_back(std::move(record));
+		}
+	}
+
+	if (records.empty()) {
+		std::cerr << "heatmap: no records" << std::endl;
+		return 1;
+	}
+
+	const uint32_t width = static_cast<uint32_t>(records.size());
+	uint32_t height;
+	std::vector<uint8_t> pixels;
+
+	if (!addressMode) {
+		height = 65;
+		std::vector<uint32_t> counts(static_cast<size_t>(width) * height, 0);
+		uint32_t peak = 1;
+
+		for (uint32_t x = 0; x < width; ++x) {
+			for (const auto& slab : records[x].slabs) {
+				uint32_t& c = counts[static_cast<size_t>(64 - std::min<uint32_t>(slab.second, 64)) * width + x];
+				peak = std::max(peak, ++c);
+			}
+		}
+
+		pixels.resize(counts.size() * 3);
+		for (size_t i = 0; i < counts.size(); ++i) {
+			if (counts[i] != 0) heat(std::log1p(counts[i]) / std::log1p(peak), &pixels[i * 3]);
+		}
+	}
+	else {
+		std::vector<uint64_t> addresses;
+		for (const auto& record : records) {
+			for (const auto& slab : record.slabs) addresses.push_back(slab.first);
+		}
+		std::sort(addresses.begin(), addresses.end());
+		addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+		height = static_cast<uint32_t>(addresses.size());
+		pixels.assign(static_cast<size_t>(width) * height * 3, 0);
+
+		for (uint32_t x = 0; x < width; ++x) {
+			for (const auto& slab : records[x].slabs) {
+				const size_t y = std::lower_bound(addresses.begin(), addresses.end(), slab.first) - addresses.begin();
+				heat(0.05 + 0.95 * slab.second / 64.0, &pixels[(y * width + x) * 3]);
+			}
+		}
+	}
+
+	std::ofstream out(argv[2], std::ios::binary);
+	out << "P6\n" << width * scale << " " << height * scale << "\n255\n";
+	for (uint32_t y = 0; y < height * scale; ++y) {
+		for (uint32_t x = 0; x < width * scale; ++x) {
+			out.write(reinterpret_cast<const char*>(&pixels[(static_cast<size_t>(y / scale) * width + x / scale) * 3]), 3);
+		}
+	}
+
+	// text summary: mean live units per slab at the first and last sample
+	for (const Record* record : { &records.front(), &records.back() }) {
+		uint64_t live = 0;
+		for (const auto& slab : record->slabs) live += slab.second;
+		std::cout << "t=" << record->micros / 1000 << "ms id=" << record->id << " slabs=" << record->slabs.size()
+			<< " mean_live=" << (record->slabs.empty() ? 0.0 : static_cast<double>(live) / record->slabs.size()) << std::endl;
+	}
+
+	return out ? 0 : 1;
+}